@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ampdu-history.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmpduHistory");
+
+NS_OBJECT_ENSURE_REGISTERED (AmpduHistory);
+
+TypeId
+AmpduHistory::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmpduHistory")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<AmpduHistory> ()
+    .AddAttribute ("HistoryLength",
+                   "The maximum number of PSDUs recorded for every station.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&AmpduHistory::m_historyLength),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("AverageWeight",
+                   "The weight of a new PSDU in the exponentially weighted moving "
+                   "averages of the A-MPDU length, size and airtime of a station.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&AmpduHistory::m_weight),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("DefaultAmpduLength",
+                   "The A-MPDU length predicted for stations no PSDU has been sent to.",
+                   UintegerValue (7),
+                   MakeUintegerAccessor (&AmpduHistory::m_defaultAmpduLength),
+                   MakeUintegerChecker<uint16_t> (1))
+  ;
+  return tid;
+}
+
+AmpduHistory::AmpduHistory ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AmpduHistory::~AmpduHistory ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+AmpduHistory::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_history.clear ();
+  Object::DoDispose ();
+}
+
+void
+AmpduHistory::NotifyPsdu (Mac48Address address, uint16_t nMpdus, uint32_t bytes, Time airtime)
+{
+  NS_LOG_FUNCTION (this << address << nMpdus << bytes << airtime);
+
+  History& history = m_history[address];
+
+  if (history.records.empty ())
+    {
+      // the first record initializes the averages
+      history.nMpdus = nMpdus;
+      history.bytes = bytes;
+      history.airtime = airtime.GetNanoSeconds ();
+    }
+  else
+    {
+      history.nMpdus += m_weight * (nMpdus - history.nMpdus);
+      history.bytes += m_weight * (bytes - history.bytes);
+      history.airtime += m_weight * (airtime.GetNanoSeconds () - history.airtime);
+    }
+
+  if (history.records.size () < m_historyLength)
+    {
+      history.records.push_back ({nMpdus, bytes, airtime});
+      history.next = history.records.size () % m_historyLength;
+    }
+  else
+    {
+      history.records[history.next] = {nMpdus, bytes, airtime};
+      history.next = (history.next + 1) % history.records.size ();
+    }
+}
+
+void
+AmpduHistory::RemoveStation (Mac48Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  m_history.erase (address);
+}
+
+uint16_t
+AmpduHistory::GetAmpduLength (Mac48Address address) const
+{
+  auto it = m_history.find (address);
+  if (it == m_history.end ())
+    {
+      return m_defaultAmpduLength;
+    }
+  return std::max<uint16_t> (static_cast<uint16_t> (std::lround (it->second.nMpdus)), 1);
+}
+
+double
+AmpduHistory::GetBytes (Mac48Address address) const
+{
+  auto it = m_history.find (address);
+  return (it != m_history.end () ? it->second.bytes : 0.0);
+}
+
+Time
+AmpduHistory::GetAirtime (Mac48Address address) const
+{
+  auto it = m_history.find (address);
+  return (it != m_history.end () ? NanoSeconds (std::llround (it->second.airtime)) : Time ());
+}
+
+std::vector<AmpduHistory::Record>
+AmpduHistory::GetRecords (Mac48Address address) const
+{
+  std::vector<Record> records;
+  auto it = m_history.find (address);
+  if (it != m_history.end ())
+    {
+      const History& history = it->second;
+      // the oldest record is at the next position once the buffer is full
+      std::size_t start = (history.records.size () < m_historyLength ? 0 : history.next);
+      for (std::size_t i = 0; i < history.records.size (); i++)
+        {
+          records.push_back (history.records[(start + i) % history.records.size ()]);
+        }
+    }
+  return records;
+}
+
+} //namespace ns3
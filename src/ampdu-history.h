@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AMPDU_HISTORY_H
+#define AMPDU_HISTORY_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/mac48-address.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * AmpduHistory keeps, for every station, the most recent PSDUs sent to the
+ * station in DL MU PPDUs: the number of MPDUs they included, their size in
+ * bytes and the duration of the PPDU carrying them. Records are stored in a
+ * per-station ring buffer, whose capacity is set by the HistoryLength
+ * attribute, and are summarized by exponentially weighted moving averages,
+ * so that the MU throughput of a set of candidate stations can be predicted
+ * from the history of those very stations.
+ *
+ * Stations for which no PSDU has been recorded yet are predicted to be sent
+ * A-MPDUs of the length set by the DefaultAmpduLength attribute.
+ */
+class AmpduHistory : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  AmpduHistory ();
+  virtual ~AmpduHistory ();
+
+  /**
+   * A PSDU sent to a station
+   */
+  struct Record
+  {
+    uint16_t nMpdus;   //!< number of MPDUs in the PSDU
+    uint32_t bytes;    //!< size of the PSDU in bytes
+    Time airtime;      //!< duration of the PPDU carrying the PSDU
+  };
+
+  /**
+   * Record that a PSDU has been sent to the given station.
+   *
+   * \param address the MAC address of the receiver
+   * \param nMpdus the number of MPDUs in the PSDU
+   * \param bytes the size of the PSDU in bytes
+   * \param airtime the duration of the PPDU carrying the PSDU
+   */
+  void NotifyPsdu (Mac48Address address, uint16_t nMpdus, uint32_t bytes, Time airtime);
+
+  /**
+   * Forget the history of the given station.
+   *
+   * \param address the MAC address of the station
+   */
+  void RemoveStation (Mac48Address address);
+
+  /**
+   * \param address the MAC address of a station
+   * \return the predicted number of MPDUs in the next A-MPDU sent to the station
+   */
+  uint16_t GetAmpduLength (Mac48Address address) const;
+
+  /**
+   * \param address the MAC address of a station
+   * \return the average size in bytes of the PSDUs sent to the station, or
+   *         zero if no PSDU has been recorded
+   */
+  double GetBytes (Mac48Address address) const;
+
+  /**
+   * \param address the MAC address of a station
+   * \return the average duration of the PPDUs carrying the PSDUs sent to the
+   *         station, or zero if no PSDU has been recorded
+   */
+  Time GetAirtime (Mac48Address address) const;
+
+  /**
+   * \param address the MAC address of a station
+   * \return the records of the station, from the oldest to the most recent
+   */
+  std::vector<Record> GetRecords (Mac48Address address) const;
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  /**
+   * History of a station
+   */
+  struct History
+  {
+    std::vector<Record> records;  //!< ring buffer of records
+    std::size_t next {0};         //!< position of the next record in the ring buffer
+    double nMpdus {0.0};          //!< EWMA of the number of MPDUs
+    double bytes {0.0};           //!< EWMA of the PSDU size
+    double airtime {0.0};         //!< EWMA of the PPDU duration in nanoseconds
+  };
+
+  uint16_t m_historyLength;       //!< max number of records per station
+  double m_weight;                //!< weight of a new record in the moving averages
+  uint16_t m_defaultAmpduLength;  //!< A-MPDU length predicted for unknown stations
+  std::map<Mac48Address, History> m_history; //!< per-station history
+};
+
+} //namespace ns3
+
+#endif /* AMPDU_HISTORY_H */
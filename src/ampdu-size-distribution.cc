@@ -0,0 +1,241 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ampdu-size-distribution.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmpduSizeDistribution");
+
+NS_OBJECT_ENSURE_REGISTERED (AmpduSizeDistribution);
+
+TypeId
+AmpduSizeDistribution::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmpduSizeDistribution")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<AmpduSizeDistribution> ()
+    .AddAttribute ("MinSamples",
+                   "The minimum number of samples that must have been collected for a "
+                   "(station, TID) pair to draw lengths from its own histogram.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&AmpduSizeDistribution::m_minSamples),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxSamples",
+                   "When the number of samples of a histogram exceeds this value, "
+                   "all the counts are halved, so that old samples fade away.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&AmpduSizeDistribution::m_maxSamples),
+                   MakeUintegerChecker<uint32_t> (2))
+    .AddAttribute ("RebuildUpdates",
+                   "The number of samples added to a histogram after which its alias "
+                   "table is rebuilt at the next draw.",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&AmpduSizeDistribution::m_rebuildUpdates),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("RebuildInterval",
+                   "The time after which the alias table of a histogram that received "
+                   "fewer than RebuildUpdates samples is rebuilt at the next draw.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&AmpduSizeDistribution::m_rebuildInterval),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+AmpduSizeDistribution::AmpduSizeDistribution ()
+  : m_rng (CreateObject<UniformRandomVariable> ())
+{
+  NS_LOG_FUNCTION (this);
+  // statistics from a single user run, used until samples are collected
+  m_prior.Set ({{64, 2513}, {14, 1256}});
+}
+
+AmpduSizeDistribution::~AmpduSizeDistribution ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+AmpduSizeDistribution::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_rng = 0;
+  m_histograms.clear ();
+  Object::DoDispose ();
+}
+
+int64_t
+AmpduSizeDistribution::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rng->SetStream (stream);
+  return 1;
+}
+
+void
+AmpduSizeDistribution::SetPrior (const std::map<uint16_t, double>& counts)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (counts.empty (), "The prior distribution cannot be empty");
+  m_prior.Set (counts);
+}
+
+void
+AmpduSizeDistribution::NotifyAmpdu (Mac48Address address, uint8_t tid, uint16_t nMpdus)
+{
+  NS_LOG_FUNCTION (this << address << +tid << nMpdus);
+  NS_ASSERT (nMpdus > 0);
+  m_histograms[{address, tid}].Add (nMpdus, m_maxSamples);
+  m_overall.Add (nMpdus, m_maxSamples);
+}
+
+uint16_t
+AmpduSizeDistribution::Sample (Mac48Address address, uint8_t tid)
+{
+  NS_LOG_FUNCTION (this << address << +tid);
+
+  double u = m_rng->GetValue (0.0, 1.0);
+  auto it = m_histograms.find ({address, tid});
+
+  if (it != m_histograms.end () && it->second.GetTotal () >= m_minSamples)
+    {
+      return it->second.Sample (u, m_rebuildUpdates, m_rebuildInterval);
+    }
+  if (m_overall.GetTotal () >= m_minSamples)
+    {
+      return m_overall.Sample (u, m_rebuildUpdates, m_rebuildInterval);
+    }
+  return m_prior.Sample (u, m_rebuildUpdates, m_rebuildInterval);
+}
+
+void
+AmpduSizeDistribution::RemoveStation (Mac48Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  for (auto it = m_histograms.begin (); it != m_histograms.end (); )
+    {
+      it = (it->first.first == address ? m_histograms.erase (it) : std::next (it));
+    }
+}
+
+void
+AmpduSizeDistribution::Histogram::Add (uint16_t length, uint32_t maxSamples)
+{
+  m_counts[length] += 1.0;
+  m_total += 1.0;
+  m_updates++;
+
+  if (m_total > maxSamples)
+    {
+      m_total = 0.0;
+      for (auto it = m_counts.begin (); it != m_counts.end (); )
+        {
+          it->second /= 2;
+          if (it->second < 0.5)
+            {
+              it = m_counts.erase (it);
+              continue;
+            }
+          m_total += it->second;
+          it++;
+        }
+    }
+}
+
+void
+AmpduSizeDistribution::Histogram::Set (const std::map<uint16_t, double>& counts)
+{
+  m_counts = counts;
+  m_total = 0.0;
+  for (const auto& count : m_counts)
+    {
+      m_total += count.second;
+    }
+  // force a rebuild at the next draw
+  m_values.clear ();
+}
+
+double
+AmpduSizeDistribution::Histogram::GetTotal (void) const
+{
+  return m_total;
+}
+
+void
+AmpduSizeDistribution::Histogram::BuildAliasTable (void)
+{
+  std::size_t n = m_counts.size ();
+  m_values.clear ();
+  m_prob.assign (n, 1.0);
+  m_alias.assign (n, 0);
+
+  std::vector<double> scaled;
+  scaled.reserve (n);
+  for (const auto& count : m_counts)
+    {
+      m_values.push_back (count.first);
+      scaled.push_back (count.second * n / m_total);
+    }
+
+  std::vector<std::size_t> small, large;
+  for (std::size_t i = 0; i < n; i++)
+    {
+      (scaled[i] < 1.0 ? small : large).push_back (i);
+    }
+
+  while (!small.empty () && !large.empty ())
+    {
+      std::size_t s = small.back ();
+      small.pop_back ();
+      std::size_t l = large.back ();
+
+      m_prob[s] = scaled[s];
+      m_alias[s] = l;
+      scaled[l] -= (1.0 - scaled[s]);
+
+      if (scaled[l] < 1.0)
+        {
+          large.pop_back ();
+          small.push_back (l);
+        }
+    }
+  // columns left in either list have probability 1 (up to rounding errors)
+  m_updates = 0;
+  m_lastBuild = Simulator::Now ();
+}
+
+uint16_t
+AmpduSizeDistribution::Histogram::Sample (double u, uint32_t rebuildUpdates, Time rebuildInterval)
+{
+  NS_ASSERT (!m_counts.empty ());
+  if (m_values.empty () || m_updates >= rebuildUpdates
+      || (m_updates > 0 && Simulator::Now () - m_lastBuild >= rebuildInterval))
+    {
+      BuildAliasTable ();
+    }
+  double x = u * m_values.size ();
+  std::size_t column = std::min (static_cast<std::size_t> (x), m_values.size () - 1);
+  return (x - column < m_prob[column] ? m_values[column] : m_values[m_alias[column]]);
+}
+
+} //namespace ns3
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AMPDU_SIZE_DISTRIBUTION_H
+#define AMPDU_SIZE_DISTRIBUTION_H
+
+#include "ns3/object.h"
+#include "ns3/mac48-address.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/nstime.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * AmpduSizeDistribution learns online the distribution of the number of MPDUs
+ * included in the A-MPDUs sent to every (station, TID) pair and allows to draw
+ * A-MPDU lengths from such distribution.
+ *
+ * Every histogram is sampled through an alias table, which is rebuilt (in a
+ * time linear in the number of distinct lengths observed) at a draw only if the
+ * histogram has received at least RebuildUpdates samples, or has changed and
+ * RebuildInterval has elapsed, since the table was last built. Between two
+ * rebuilds, draws follow a slightly outdated distribution and take constant
+ * time. Draws use a RandomVariableStream whose stream number can be fixed via
+ * AssignStreams, which makes simulations reproducible.
+ *
+ * When the number of samples collected for a (station, TID) pair is below
+ * the MinSamples attribute, draws are taken from the histogram of all the
+ * stations, or from a prior distribution if not enough samples have been
+ * collected overall. Histograms are aged by halving their counts when the
+ * number of samples exceeds the MaxSamples attribute.
+ */
+class AmpduSizeDistribution : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  AmpduSizeDistribution ();
+  virtual ~AmpduSizeDistribution ();
+
+  /**
+   * Record that an A-MPDU including the given number of MPDUs has been sent
+   * to the given station.
+   *
+   * \param address the MAC address of the receiver
+   * \param tid the TID of the MPDUs
+   * \param nMpdus the number of MPDUs in the A-MPDU
+   */
+  void NotifyAmpdu (Mac48Address address, uint8_t tid, uint16_t nMpdus);
+
+  /**
+   * Draw an A-MPDU length for the given station and TID.
+   *
+   * \param address the MAC address of the receiver
+   * \param tid the TID of the MPDUs
+   * \return the number of MPDUs in the A-MPDU
+   */
+  uint16_t Sample (Mac48Address address, uint8_t tid);
+
+  /**
+   * Forget the histograms of the given station.
+   *
+   * \param address the MAC address of the station
+   */
+  void RemoveStation (Mac48Address address);
+
+  /**
+   * Set the prior distribution, used when not enough samples are available.
+   *
+   * \param counts the number of times each A-MPDU length has been observed
+   */
+  void SetPrior (const std::map<uint16_t, double>& counts);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model. Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  /**
+   * Histogram of A-MPDU lengths along with its alias table
+   */
+  class Histogram
+  {
+  public:
+    /**
+     * Add a sample to the histogram.
+     *
+     * \param length the A-MPDU length
+     * \param maxSamples the number of samples above which counts are halved
+     */
+    void Add (uint16_t length, uint32_t maxSamples);
+    /**
+     * Set the counts of the histogram.
+     *
+     * \param counts the count of each A-MPDU length
+     */
+    void Set (const std::map<uint16_t, double>& counts);
+    /**
+     * Draw a length, rebuilding the alias table if it has never been built,
+     * if at least the given number of samples have been added since it was
+     * last built, or if samples have been added and the given interval has
+     * elapsed since it was last built.
+     *
+     * \param u a random value uniformly distributed in [0, 1)
+     * \param rebuildUpdates the number of added samples triggering a rebuild
+     * \param rebuildInterval the interval after which a changed histogram is rebuilt
+     * \return the A-MPDU length
+     */
+    uint16_t Sample (double u, uint32_t rebuildUpdates, Time rebuildInterval);
+    /**
+     * \return the number of (possibly aged) samples in the histogram
+     */
+    double GetTotal (void) const;
+
+  private:
+    /// Rebuild the alias table (Vose's method)
+    void BuildAliasTable (void);
+
+    std::map<uint16_t, double> m_counts;  //!< count of each A-MPDU length
+    double m_total {0.0};                 //!< sum of the counts
+    uint32_t m_updates {0};               //!< samples added since the alias table was built
+    Time m_lastBuild;                     //!< when the alias table was last built
+    std::vector<uint16_t> m_values;       //!< A-MPDU lengths
+    std::vector<double> m_prob;           //!< probability of keeping the column value
+    std::vector<std::size_t> m_alias;     //!< alias of every column
+  };
+
+  uint32_t m_minSamples;                  //!< min samples to use a per-station histogram
+  uint32_t m_maxSamples;                  //!< samples above which histograms are aged
+  uint32_t m_rebuildUpdates;              //!< added samples triggering an alias table rebuild
+  Time m_rebuildInterval;                 //!< interval after which a changed alias table is rebuilt
+  Ptr<UniformRandomVariable> m_rng;       //!< random variable used to draw lengths
+  std::map<std::pair<Mac48Address, uint8_t>, Histogram> m_histograms; //!< per-(station, TID) histograms
+  Histogram m_overall;                    //!< histogram of all the stations
+  Histogram m_prior;                      //!< prior distribution
+};
+
+} //namespace ns3
+
+#endif /* AMPDU_SIZE_DISTRIBUTION_H */
@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "backlog-index.h"
+#include "wifi-mac-queue-item.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BacklogIndex");
+
+NS_OBJECT_ENSURE_REGISTERED (BacklogIndex);
+
+TypeId
+BacklogIndex::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BacklogIndex")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<BacklogIndex> ()
+    .AddTraceSource ("EligibilityState",
+                     "At least one TID of a station that had no eligible TIDs became "
+                     "eligible, or vice versa.",
+                     MakeTraceSourceAccessor (&BacklogIndex::m_eligibilityTrace),
+                     "ns3::BacklogIndex::EligibilityStateCallback")
+  ;
+  return tid;
+}
+
+BacklogIndex::BacklogIndex ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BacklogIndex::~BacklogIndex ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+BacklogIndex::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_backlog.clear ();
+  m_backlogged.clear ();
+  m_eligible.clear ();
+  Object::DoDispose ();
+}
+
+void
+BacklogIndex::NotifyEnqueue (Ptr<const WifiMacQueueItem> item)
+{
+  NS_LOG_FUNCTION (this << *item);
+
+  const WifiMacHeader& hdr = item->GetHeader ();
+  if (!hdr.IsQosData () || hdr.GetAddr1 ().IsGroup ())
+    {
+      return;
+    }
+
+  auto it = m_backlog.insert ({hdr.GetAddr1 (), StationBacklog ()}).first;
+  Backlog& backlog = it->second[hdr.GetQosTid ()];
+  backlog.packets++;
+  backlog.bytes += item->GetSize ();
+  Update (it);
+}
+
+void
+BacklogIndex::NotifyDequeue (Ptr<const WifiMacQueueItem> item)
+{
+  NS_LOG_FUNCTION (this << *item);
+
+  const WifiMacHeader& hdr = item->GetHeader ();
+  if (!hdr.IsQosData () || hdr.GetAddr1 ().IsGroup ())
+    {
+      return;
+    }
+
+  auto it = m_backlog.find (hdr.GetAddr1 ());
+  if (it == m_backlog.end ())
+    {
+      // the packet was enqueued before the index was fed
+      return;
+    }
+
+  Backlog& backlog = it->second[hdr.GetQosTid ()];
+  NS_ASSERT (backlog.packets > 0 && backlog.bytes >= item->GetSize ());
+  backlog.packets--;
+  backlog.bytes -= item->GetSize ();
+  Update (it);
+}
+
+void
+BacklogIndex::SetBaEstablished (Mac48Address address, uint8_t tid, bool established)
+{
+  NS_LOG_FUNCTION (this << address << +tid << established);
+  NS_ASSERT (tid < 8);
+
+  auto it = m_backlog.insert ({address, StationBacklog ()}).first;
+  it->second[tid].baEstablished = established;
+  Update (it);
+}
+
+void
+BacklogIndex::RemoveStation (Mac48Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+
+  auto it = m_backlog.find (address);
+  if (it != m_backlog.end ())
+    {
+      for (auto& backlog : it->second)
+        {
+          backlog.baEstablished = false;
+        }
+      Update (it);
+    }
+}
+
+void
+BacklogIndex::Update (std::map<Mac48Address, StationBacklog>::iterator it)
+{
+  bool backlogged = false;
+  bool eligible = false;
+  bool agreement = false;
+  for (const auto& backlog : it->second)
+    {
+      backlogged = backlogged || (backlog.packets > 0);
+      eligible = eligible || (backlog.packets > 0 && backlog.baEstablished);
+      agreement = agreement || backlog.baEstablished;
+    }
+
+  Mac48Address address = it->first;
+  if (backlogged)
+    {
+      m_backlogged.insert (address);
+    }
+  else
+    {
+      m_backlogged.erase (address);
+    }
+
+  if (eligible && m_eligible.insert (address).second)
+    {
+      m_eligibilityTrace (address, true);
+    }
+  else if (!eligible && m_eligible.erase (address) > 0)
+    {
+      m_eligibilityTrace (address, false);
+    }
+
+  if (!backlogged && !agreement)
+    {
+      // nothing left to track
+      m_backlog.erase (it);
+    }
+}
+
+BacklogIndex::Backlog
+BacklogIndex::GetBacklog (Mac48Address address, uint8_t tid) const
+{
+  NS_ASSERT (tid < 8);
+  auto it = m_backlog.find (address);
+  if (it == m_backlog.end ())
+    {
+      return Backlog ();
+    }
+  return it->second[tid];
+}
+
+bool
+BacklogIndex::IsEligible (Mac48Address address, uint8_t tid) const
+{
+  Backlog backlog = GetBacklog (address, tid);
+  return backlog.packets > 0 && backlog.baEstablished;
+}
+
+const std::set<Mac48Address>&
+BacklogIndex::GetBackloggedStations (void) const
+{
+  return m_backlogged;
+}
+
+bool
+BacklogIndex::IsEligible (Mac48Address address) const
+{
+  return m_eligible.find (address) != m_eligible.end ();
+}
+
+} //namespace ns3
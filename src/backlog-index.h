@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BACKLOG_INDEX_H
+#define BACKLOG_INDEX_H
+
+#include "ns3/object.h"
+#include "ns3/mac48-address.h"
+#include "ns3/traced-callback.h"
+#include <array>
+#include <map>
+#include <set>
+
+namespace ns3 {
+
+class WifiMacQueueItem;
+
+/**
+ * \ingroup wifi
+ *
+ * BacklogIndex keeps track of the number of packets and bytes queued by the AP
+ * for every (station, TID) pair, as well as of the state of the Block Ack
+ * agreement for every (station, TID) pair. It is meant to be fed by the
+ * Enqueue and Dequeue traces of the AP queues and by the AgreementState trace
+ * of the Block Ack managers, so that a scheduler only needs to visit the
+ * stations the AP has traffic for.
+ *
+ * Packets dropped after being dequeued (e.g., because their lifetime expired)
+ * are notified through the Dequeue trace, while packets dropped before being
+ * enqueued have never been counted, hence drops require no specific handling.
+ *
+ * A station is eligible if at least one of its TIDs is eligible (see
+ * IsEligible). Changes of eligibility are notified through the
+ * EligibilityState trace, so that the stations that can be served in a DL MU
+ * PPDU can be indexed without visiting the others.
+ *
+ * The packets queued for a station are counted until they leave the queues,
+ * even if the station is removed, so that the counters stay consistent if
+ * the station reassociates while its old packets are still queued.
+ */
+class BacklogIndex : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  BacklogIndex ();
+  virtual ~BacklogIndex ();
+
+  /// Packets and bytes queued for a (station, TID) pair
+  struct Backlog
+  {
+    uint32_t packets {0};       //!< number of queued packets
+    uint32_t bytes {0};         //!< number of queued bytes
+    bool baEstablished {false}; //!< whether a BA agreement is established
+  };
+
+  /**
+   * Notify that the given item has been enqueued.
+   *
+   * \param item the enqueued item
+   */
+  void NotifyEnqueue (Ptr<const WifiMacQueueItem> item);
+  /**
+   * Notify that the given item has been dequeued (or removed) from a queue.
+   *
+   * \param item the dequeued item
+   */
+  void NotifyDequeue (Ptr<const WifiMacQueueItem> item);
+  /**
+   * Set the state of the Block Ack agreement with the given station for the
+   * given TID.
+   *
+   * \param address the MAC address of the station
+   * \param tid the TID
+   * \param established whether the agreement is established
+   */
+  void SetBaEstablished (Mac48Address address, uint8_t tid, bool established);
+  /**
+   * Forget the Block Ack agreements of the given station. The packets queued
+   * for the station are still counted until they are dequeued.
+   *
+   * \param address the MAC address of the station
+   */
+  void RemoveStation (Mac48Address address);
+
+  /**
+   * \param address the MAC address of the station
+   * \param tid the TID
+   * \return the backlog of the given station for the given TID
+   */
+  Backlog GetBacklog (Mac48Address address, uint8_t tid) const;
+  /**
+   * \param address the MAC address of the station
+   * \param tid the TID
+   * \return true if the AP has packets queued for the given station and TID
+   *         and a BA agreement is established
+   */
+  bool IsEligible (Mac48Address address, uint8_t tid) const;
+  /**
+   * \return the set of stations the AP has packets queued for
+   */
+  const std::set<Mac48Address>& GetBackloggedStations (void) const;
+  /**
+   * \param address the MAC address of the station
+   * \return true if at least one TID of the given station is eligible
+   */
+  bool IsEligible (Mac48Address address) const;
+
+  /**
+   * TracedCallback signature for changes of the eligibility of a station.
+   *
+   * \param address the MAC address of the station
+   * \param eligible whether at least one TID of the station is eligible
+   */
+  typedef void (* EligibilityStateCallback)(Mac48Address address, bool eligible);
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  /// Per-TID backlog of a station
+  typedef std::array<Backlog, 8> StationBacklog;
+
+  /**
+   * Update the set of eligible stations after the backlog of the given
+   * station changed, and forget the station if nothing is left to track.
+   *
+   * \param it iterator to the backlog of the station
+   */
+  void Update (std::map<Mac48Address, StationBacklog>::iterator it);
+
+  std::map<Mac48Address, StationBacklog> m_backlog;  //!< per-station backlog
+  std::set<Mac48Address> m_backlogged;               //!< stations with queued packets
+  std::set<Mac48Address> m_eligible;                 //!< stations with at least one eligible TID
+  TracedCallback<Mac48Address, bool> m_eligibilityTrace;  //!< a station became (not) eligible
+};
+
+} //namespace ns3
+
+#endif /* BACKLOG_INDEX_H */
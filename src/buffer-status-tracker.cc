@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "buffer-status-tracker.h"
+#include <algorithm>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BufferStatusTracker");
+
+NS_OBJECT_ENSURE_REGISTERED (BufferStatusTracker);
+
+TypeId
+BufferStatusTracker::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BufferStatusTracker")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<BufferStatusTracker> ()
+    .AddAttribute ("MaxReportAge",
+                   "The age after which a buffer status report is stale and new "
+                   "reports are worth soliciting.",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&BufferStatusTracker::m_maxReportAge),
+                   MakeTimeChecker ())
+    .AddAttribute ("ArrivalRateWeight",
+                   "The weight of a new sample in the exponentially weighted moving "
+                   "average of the arrival rate of a station.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&BufferStatusTracker::m_rateWeight),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+BufferStatusTracker::BufferStatusTracker ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BufferStatusTracker::~BufferStatusTracker ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+BufferStatusTracker::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_status.clear ();
+  Object::DoDispose ();
+}
+
+void
+BufferStatusTracker::NotifyReport (Mac48Address address, uint8_t queueSize)
+{
+  NS_LOG_FUNCTION (this << address << +queueSize);
+
+  if (queueSize == 255)
+    {
+      return;
+    }
+
+  Time now = Simulator::Now ();
+  auto it = m_status.find (address);
+
+  if (it != m_status.end () && it->second.queueSize < 254 && queueSize < 254
+      && now > it->second.reportTime)
+    {
+      // the bytes arrived since the previous report are the bytes reported
+      // now minus the bytes that were left from the previous report
+      double left = std::max (it->second.queueSize * 256.0 - it->second.received, 0.0);
+      double arrived = std::max (queueSize * 256.0 - left, 0.0);
+      double rate = arrived / (now - it->second.reportTime).GetSeconds ();
+      it->second.arrivalRate = (1 - m_rateWeight) * it->second.arrivalRate + m_rateWeight * rate;
+      NS_LOG_DEBUG ("Arrival rate of " << address << ": " << it->second.arrivalRate << " B/s");
+    }
+
+  Status& status = m_status[address];
+  status.queueSize = queueSize;
+  status.reportTime = now;
+  status.received = 0;
+}
+
+void
+BufferStatusTracker::NotifyUlData (Mac48Address address, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << address << bytes);
+
+  auto it = m_status.find (address);
+  if (it != m_status.end ())
+    {
+      it->second.received += bytes;
+    }
+}
+
+void
+BufferStatusTracker::RemoveStation (Mac48Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  m_status.erase (address);
+}
+
+uint8_t
+BufferStatusTracker::GetLastReport (Mac48Address address) const
+{
+  auto it = m_status.find (address);
+  return (it != m_status.end () ? it->second.queueSize : 255);
+}
+
+bool
+BufferStatusTracker::HasReport (Mac48Address address) const
+{
+  return m_status.find (address) != m_status.end ();
+}
+
+bool
+BufferStatusTracker::IsStale (Mac48Address address) const
+{
+  auto it = m_status.find (address);
+  return it == m_status.end () || Simulator::Now () - it->second.reportTime > m_maxReportAge;
+}
+
+uint32_t
+BufferStatusTracker::GetEstimate (Mac48Address address) const
+{
+  auto it = m_status.find (address);
+  if (it == m_status.end ())
+    {
+      return 0;
+    }
+  if (it->second.queueSize == 254)
+    {
+      return std::numeric_limits<uint32_t>::max ();
+    }
+
+  const Status& status = it->second;
+  double left = std::max (status.queueSize * 256.0 - status.received, 0.0);
+  double arrived = status.arrivalRate * (Simulator::Now () - status.reportTime).GetSeconds ();
+  return static_cast<uint32_t> (std::min (left + arrived,
+                                          static_cast<double> (std::numeric_limits<uint32_t>::max ())));
+}
+
+} //namespace ns3
@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BUFFER_STATUS_TRACKER_H
+#define BUFFER_STATUS_TRACKER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/mac48-address.h"
+#include <map>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * BufferStatusTracker keeps track of the buffer status reported by every
+ * station, of the time the report was received and of the UL data received
+ * from the station since then, so that the number of bytes buffered by the
+ * station can be predicted between reports rather than assumed constant.
+ *
+ * The prediction is the reported buffer size minus the bytes received since
+ * the report, plus the bytes expected to arrive since the report at the
+ * arrival rate of the station. The arrival rate is estimated, every time a
+ * report is received, as the difference between the reported buffer size
+ * and the predicted one without arrivals, divided by the time elapsed since
+ * the previous report, and is smoothed by an exponentially weighted moving
+ * average.
+ *
+ * Reports older than the MaxReportAge attribute are stale, which tells the
+ * scheduler that it is worth soliciting new reports (e.g., via BSRP).
+ */
+class BufferStatusTracker : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  BufferStatusTracker ();
+  virtual ~BufferStatusTracker ();
+
+  /**
+   * Notify that the given buffer status has been reported by the given station.
+   *
+   * \param address the MAC address of the station
+   * \param queueSize the reported queue size, encoded as in the Queue Size
+   *        subfield (in units of 256 octets, 254 meaning larger than 64768
+   *        octets and 255 meaning unknown, which is ignored)
+   */
+  void NotifyReport (Mac48Address address, uint8_t queueSize);
+  /**
+   * Notify that UL data has been received from the given station.
+   *
+   * \param address the MAC address of the station
+   * \param bytes the number of bytes received
+   */
+  void NotifyUlData (Mac48Address address, uint32_t bytes);
+  /**
+   * Forget everything about the given station.
+   *
+   * \param address the MAC address of the station
+   */
+  void RemoveStation (Mac48Address address);
+
+  /**
+   * \param address the MAC address of the station
+   * \return the last queue size reported by the station (255 if none)
+   */
+  uint8_t GetLastReport (Mac48Address address) const;
+  /**
+   * \param address the MAC address of the station
+   * \return true if the station has reported its buffer status at least once
+   */
+  bool HasReport (Mac48Address address) const;
+  /**
+   * \param address the MAC address of the station
+   * \return true if the station has never reported its buffer status or the
+   *         last report is older than the maximum report age
+   */
+  bool IsStale (Mac48Address address) const;
+  /**
+   * \param address the MAC address of the station
+   * \return the predicted number of bytes buffered by the station (the maximum
+   *         value of an uint32_t if the station reported a buffer size that is
+   *         not limited, zero if the station has never reported)
+   */
+  uint32_t GetEstimate (Mac48Address address) const;
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  /// Buffer status of a station
+  struct Status
+  {
+    uint8_t queueSize {255};      //!< last reported queue size (encoded)
+    Time reportTime;              //!< time of the last report
+    uint32_t received {0};        //!< bytes received since the last report
+    double arrivalRate {0.0};     //!< smoothed arrival rate (bytes per second)
+  };
+
+  Time m_maxReportAge;                    //!< age after which a report is stale
+  double m_rateWeight;                    //!< weight of new arrival rate samples
+  std::map<Mac48Address, Status> m_status; //!< per-station buffer status
+};
+
+} //namespace ns3
+
+#endif /* BUFFER_STATUS_TRACKER_H */
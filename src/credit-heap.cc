@@ -0,0 +1,350 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "credit-heap.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+const std::size_t CreditHeap::NONE = std::numeric_limits<std::size_t>::max ();
+
+/// Magnitude of the offset above which it is folded into the stored credits
+static const double MAX_OFFSET = 1e9;
+
+CreditHeap::CreditHeap ()
+  : m_nextSeq (0),
+    m_offset (0.0)
+{
+}
+
+CreditHeap::ActiveWalk::ActiveWalk (const CreditHeap& heap)
+  : m_heap (&heap)
+{
+  if (!heap.m_heap[ACTIVE].empty ())
+    {
+      m_frontier.push_back (0);
+    }
+}
+
+bool
+CreditHeap::ActiveWalk::IsDone (void) const
+{
+  return m_frontier.empty ();
+}
+
+std::size_t
+CreditHeap::ActiveWalk::Get (void) const
+{
+  NS_ASSERT (!m_frontier.empty ());
+  return m_heap->m_heap[ACTIVE][m_frontier.front ()];
+}
+
+void
+CreditHeap::ActiveWalk::Next (void)
+{
+  NS_ASSERT (!m_frontier.empty ());
+  auto less = [this] (std::size_t i, std::size_t j) { return Less (i, j); };
+
+  // the children of the visited station are the only stations that may come
+  // right after it, among those not visited yet
+  std::size_t pos = m_frontier.front ();
+  std::pop_heap (m_frontier.begin (), m_frontier.end (), less);
+  m_frontier.pop_back ();
+
+  for (std::size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < m_heap->m_heap[ACTIVE].size (); child++)
+    {
+      m_frontier.push_back (child);
+      std::push_heap (m_frontier.begin (), m_frontier.end (), less);
+    }
+}
+
+bool
+CreditHeap::ActiveWalk::Less (std::size_t i, std::size_t j) const
+{
+  return m_heap->Less (m_heap->m_heap[ACTIVE][i], m_heap->m_heap[ACTIVE][j]);
+}
+
+void
+CreditHeap::Insert (std::size_t slot, double credits)
+{
+  if (slot >= m_keys.size ())
+    {
+      m_keys.resize (slot + 1, 0.0);
+      m_pos.resize (slot + 1, NONE);
+      m_heapId.resize (slot + 1, INACTIVE);
+      m_seq.resize (slot + 1, 0);
+    }
+  NS_ASSERT (m_pos[slot] == NONE);
+
+  m_keys[slot] = credits - m_offset;
+  m_seq[slot] = m_nextSeq++;
+  Attach (slot, INACTIVE);
+}
+
+void
+CreditHeap::Remove (std::size_t slot)
+{
+  NS_ASSERT (Contains (slot));
+  Detach (slot);
+}
+
+bool
+CreditHeap::Contains (std::size_t slot) const
+{
+  return slot < m_pos.size () && m_pos[slot] != NONE;
+}
+
+void
+CreditHeap::Clear (void)
+{
+  for (auto& heap : m_heap)
+    {
+      heap.clear ();
+    }
+  m_keys.clear ();
+  m_pos.clear ();
+  m_heapId.clear ();
+  m_seq.clear ();
+  m_nextSeq = 0;
+  m_offset = 0.0;
+}
+
+void
+CreditHeap::SetActive (std::size_t slot, bool active)
+{
+  NS_ASSERT (Contains (slot));
+
+  HeapId id = (active ? ACTIVE : INACTIVE);
+  if (m_heapId[slot] != id)
+    {
+      Detach (slot);
+      Attach (slot, id);
+    }
+}
+
+bool
+CreditHeap::IsActive (std::size_t slot) const
+{
+  NS_ASSERT (Contains (slot));
+  return m_heapId[slot] == ACTIVE;
+}
+
+double
+CreditHeap::GetCredits (std::size_t slot) const
+{
+  NS_ASSERT (Contains (slot));
+  return m_keys[slot] + m_offset;
+}
+
+void
+CreditHeap::Add (std::size_t slot, double credits)
+{
+  NS_ASSERT (Contains (slot));
+
+  HeapId id = static_cast<HeapId> (m_heapId[slot]);
+  m_keys[slot] += credits;
+  if (credits > 0)
+    {
+      SiftUp (id, m_pos[slot]);
+    }
+  else
+    {
+      // the station goes after the stations having the same credits
+      m_seq[slot] = m_nextSeq++;
+      SiftDown (id, m_pos[slot]);
+    }
+}
+
+void
+CreditHeap::AddToAll (double credits)
+{
+  m_offset += credits;
+
+  if (std::abs (m_offset) > MAX_OFFSET)
+    {
+      // fold the offset into the stored credits to preserve precision
+      for (auto& key : m_keys)
+        {
+          key += m_offset;
+        }
+      m_offset = 0.0;
+    }
+}
+
+void
+CreditHeap::ClampAbove (double maxCredits)
+{
+  double maxKey = maxCredits - m_offset;
+
+  for (uint8_t i = 0; i < N_HEAPS; i++)
+    {
+      HeapId id = static_cast<HeapId> (i);
+      std::vector<std::size_t>& heap = m_heap[id];
+
+      // The stations exceeding the cap form a subtree rooted at the top of
+      // the heap. Setting all of them to the cap preserves the order on
+      // credits, but not the order among the stations having the same credits
+      std::vector<std::size_t> clamped;
+      std::vector<std::size_t> stack;
+      if (!heap.empty ())
+        {
+          stack.push_back (0);
+        }
+      while (!stack.empty ())
+        {
+          std::size_t pos = stack.back ();
+          stack.pop_back ();
+          if (m_keys[heap[pos]] > maxKey)
+            {
+              m_keys[heap[pos]] = maxKey;
+              clamped.push_back (pos);
+              for (std::size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap.size (); child++)
+                {
+                  stack.push_back (child);
+                }
+            }
+        }
+
+      // restore the heap property bottom-up over the clamped subtree
+      std::sort (clamped.begin (), clamped.end ());
+      for (auto it = clamped.rbegin (); it != clamped.rend (); it++)
+        {
+          SiftDown (id, *it);
+        }
+    }
+}
+
+std::size_t
+CreditHeap::Top (void) const
+{
+  NS_ASSERT (!IsEmpty ());
+
+  if (m_heap[ACTIVE].empty ())
+    {
+      return m_heap[INACTIVE].front ();
+    }
+  if (m_heap[INACTIVE].empty ())
+    {
+      return m_heap[ACTIVE].front ();
+    }
+  return (Less (m_heap[ACTIVE].front (), m_heap[INACTIVE].front ())
+          ? m_heap[INACTIVE].front () : m_heap[ACTIVE].front ());
+}
+
+std::size_t
+CreditHeap::GetSize (void) const
+{
+  return m_heap[ACTIVE].size () + m_heap[INACTIVE].size ();
+}
+
+bool
+CreditHeap::IsEmpty (void) const
+{
+  return GetSize () == 0;
+}
+
+void
+CreditHeap::Attach (std::size_t slot, HeapId id)
+{
+  m_heapId[slot] = id;
+  m_pos[slot] = m_heap[id].size ();
+  m_heap[id].push_back (slot);
+  SiftUp (id, m_pos[slot]);
+}
+
+void
+CreditHeap::Detach (std::size_t slot)
+{
+  HeapId id = static_cast<HeapId> (m_heapId[slot]);
+  std::vector<std::size_t>& heap = m_heap[id];
+  std::size_t pos = m_pos[slot];
+  std::size_t last = heap.size () - 1;
+
+  if (pos != last)
+    {
+      Swap (id, pos, last);
+    }
+  heap.pop_back ();
+  m_pos[slot] = NONE;
+
+  if (pos < heap.size ())
+    {
+      // the station moved to the position of the removed one may need to go
+      // either up or down
+      std::size_t moved = heap[pos];
+      SiftUp (id, pos);
+      SiftDown (id, m_pos[moved]);
+    }
+}
+
+bool
+CreditHeap::Less (std::size_t a, std::size_t b) const
+{
+  return m_keys[a] < m_keys[b] || (m_keys[a] == m_keys[b] && m_seq[a] > m_seq[b]);
+}
+
+void
+CreditHeap::Swap (HeapId id, std::size_t i, std::size_t j)
+{
+  std::vector<std::size_t>& heap = m_heap[id];
+  std::swap (heap[i], heap[j]);
+  m_pos[heap[i]] = i;
+  m_pos[heap[j]] = j;
+}
+
+void
+CreditHeap::SiftUp (HeapId id, std::size_t pos)
+{
+  const std::vector<std::size_t>& heap = m_heap[id];
+
+  while (pos > 0)
+    {
+      std::size_t parent = (pos - 1) / 2;
+      if (!Less (heap[parent], heap[pos]))
+        {
+          break;
+        }
+      Swap (id, parent, pos);
+      pos = parent;
+    }
+}
+
+void
+CreditHeap::SiftDown (HeapId id, std::size_t pos)
+{
+  const std::vector<std::size_t>& heap = m_heap[id];
+  std::size_t size = heap.size ();
+
+  while (2 * pos + 1 < size)
+    {
+      std::size_t child = 2 * pos + 1;
+      if (child + 1 < size && Less (heap[child], heap[child + 1]))
+        {
+          child++;
+        }
+      if (!Less (heap[pos], heap[child]))
+        {
+          break;
+        }
+      Swap (id, pos, child);
+      pos = child;
+    }
+}
+
+} //namespace ns3
@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CREDIT_HEAP_H
+#define CREDIT_HEAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * CreditHeap is an indexed max-heap storing the credits of a set of stations.
+ * Every station is identified by a slot chosen by the caller (typically, the
+ * index of the station in a StationTable), so that several heaps can index
+ * the same set of stations.
+ *
+ * Credits are stored relative to a global offset, so that adding the same
+ * amount of credits to all the stations takes constant time. Capping the
+ * credits only visits the stations whose credits exceed the cap, which form
+ * a subtree rooted at the top of the heap, and changing the credits of a
+ * single station takes logarithmic time.
+ *
+ * Stations are either active (e.g., the AP has frames queued for them) or
+ * inactive, and the two sets are kept in separate heaps sharing the same
+ * offset. An ActiveWalk visits the active stations in decreasing order of
+ * credits: visiting the first k of them takes O(k log k) time, regardless
+ * of the number of stations. Stations having the same credits are ordered
+ * by the time they were last charged credits (or added), the least recent
+ * first, so that they are served in a round robin fashion.
+ */
+class CreditHeap
+{
+public:
+  CreditHeap ();
+
+  /**
+   * Visits the active stations of a CreditHeap in decreasing order of credits
+   * without modifying the heap. The heap must not be modified while walking.
+   */
+  class ActiveWalk
+  {
+  public:
+    /**
+     * \param heap the heap whose active stations are visited
+     */
+    explicit ActiveWalk (const CreditHeap& heap);
+
+    /**
+     * \return true if all the active stations have been visited
+     */
+    bool IsDone (void) const;
+    /**
+     * \return the slot of the station being visited (the walk must not be done)
+     */
+    std::size_t Get (void) const;
+    /**
+     * Move to the active station with the next highest credits.
+     */
+    void Next (void);
+
+  private:
+    /**
+     * \param i a heap position
+     * \param j a heap position
+     * \return true if the active station at position i comes after the one at position j
+     */
+    bool Less (std::size_t i, std::size_t j) const;
+
+    const CreditHeap* m_heap;             //!< the heap being walked
+    std::vector<std::size_t> m_frontier;  //!< positions of the candidates to visit next, as a max-heap
+  };
+
+  /**
+   * Add a station. The station is inactive.
+   *
+   * \param slot the slot of the station (must not be in the heap already)
+   * \param credits the initial credits of the station
+   */
+  void Insert (std::size_t slot, double credits);
+  /**
+   * Remove a station.
+   *
+   * \param slot the slot of the station
+   */
+  void Remove (std::size_t slot);
+  /**
+   * \param slot a slot
+   * \return true if the station with the given slot is in the heap
+   */
+  bool Contains (std::size_t slot) const;
+  /**
+   * Remove all the stations.
+   */
+  void Clear (void);
+  /**
+   * Set whether the given station is active.
+   *
+   * \param slot the slot of the station
+   * \param active whether the station is active
+   */
+  void SetActive (std::size_t slot, bool active);
+  /**
+   * \param slot the slot of the station
+   * \return true if the station is active
+   */
+  bool IsActive (std::size_t slot) const;
+  /**
+   * \param slot the slot of a station
+   * \return the credits of the station
+   */
+  double GetCredits (std::size_t slot) const;
+  /**
+   * Add the given amount of credits to the given station. A station charged
+   * credits (i.e., receiving a negative amount) comes after the stations
+   * having the same credits.
+   *
+   * \param slot the slot of the station
+   * \param credits the credits to add (can be negative)
+   */
+  void Add (std::size_t slot, double credits);
+  /**
+   * Add the given amount of credits to all the stations.
+   *
+   * \param credits the credits to add (can be negative)
+   */
+  void AddToAll (double credits);
+  /**
+   * Cap the credits of all the stations to the given value.
+   *
+   * \param maxCredits the maximum amount of credits a station can have
+   */
+  void ClampAbove (double maxCredits);
+  /**
+   * \return the slot of the station with the most credits, active or not (the
+   *         heap must not be empty)
+   */
+  std::size_t Top (void) const;
+  /**
+   * \return the number of stations
+   */
+  std::size_t GetSize (void) const;
+  /**
+   * \return true if there are no stations
+   */
+  bool IsEmpty (void) const;
+
+private:
+  /// The heaps storing the active and the inactive stations
+  enum HeapId : uint8_t
+  {
+    ACTIVE = 0,
+    INACTIVE,
+    N_HEAPS
+  };
+
+  /**
+   * Add the given station to the given heap.
+   *
+   * \param slot the slot of the station
+   * \param id the heap
+   */
+  void Attach (std::size_t slot, HeapId id);
+  /**
+   * Remove the given station from its heap, without forgetting its credits.
+   *
+   * \param slot the slot of the station
+   */
+  void Detach (std::size_t slot);
+  /**
+   * Move the station at the given position of the given heap up until the
+   * heap property holds.
+   *
+   * \param id the heap
+   * \param pos the heap position
+   */
+  void SiftUp (HeapId id, std::size_t pos);
+  /**
+   * Move the station at the given position of the given heap down until the
+   * heap property holds.
+   *
+   * \param id the heap
+   * \param pos the heap position
+   */
+  void SiftDown (HeapId id, std::size_t pos);
+  /**
+   * Swap the stations at the given positions of the given heap.
+   *
+   * \param id the heap
+   * \param i the first heap position
+   * \param j the second heap position
+   */
+  void Swap (HeapId id, std::size_t i, std::size_t j);
+  /**
+   * \param a the slot of a station
+   * \param b the slot of another station
+   * \return true if station a comes after station b, i.e., it has less credits
+   *         or the same credits and it has been charged more recently
+   */
+  bool Less (std::size_t a, std::size_t b) const;
+
+  static const std::size_t NONE;              //!< position of slots not in the heap
+
+  std::vector<std::size_t> m_heap[N_HEAPS];   //!< slots, arranged as max-heaps on credits
+  std::vector<double> m_keys;                 //!< credits of each slot, minus the offset
+  std::vector<std::size_t> m_pos;             //!< heap position of each slot
+  std::vector<uint8_t> m_heapId;              //!< heap of each slot
+  std::vector<uint64_t> m_seq;                //!< when each slot was last charged credits
+  uint64_t m_nextSeq;                         //!< next value of the charging sequence
+  double m_offset;                            //!< credits added to all the stations
+};
+
+} //namespace ns3
+
+#endif /* CREDIT_HEAP_H */
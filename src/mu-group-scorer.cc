@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "mu-group-scorer.h"
+#include "sumu-cost-model.h"
+#include <algorithm>
+
+namespace ns3 {
+
+MuGroupScorer::MuGroupScorer ()
+  : m_bestGroupSize (0)
+{
+}
+
+void
+MuGroupScorer::Clear (void)
+{
+  m_mcs.clear ();
+  m_nss.clear ();
+  m_ampduLength.clear ();
+  m_bestGroupSize = 0;
+}
+
+void
+MuGroupScorer::AddUser (uint8_t mcs, uint8_t nss, uint16_t ampduLength)
+{
+  m_mcs.push_back (mcs);
+  m_nss.push_back (nss);
+  m_ampduLength.push_back (ampduLength);
+}
+
+std::size_t
+MuGroupScorer::GetNUsers (void) const
+{
+  return m_mcs.size ();
+}
+
+void
+MuGroupScorer::GatherDataDurations (const SuMuCostModel& costModel, HeRu::RuType ruType, std::size_t nUsers,
+                                    std::size_t nCentral26TonesRus, uint16_t guardInterval)
+{
+  std::size_t groupSize = nUsers + nCentral26TonesRus;
+
+  // the HE-SIG-B field of the DL MU PPDU carries the allocation of the whole group
+  for (std::size_t i = 0; i < groupSize; i++)
+    {
+      m_dataDuration[i] = costModel.GetDataDuration (m_mcs[i], m_nss[i],
+                                                     (i < nUsers ? ruType : HeRu::RU_26_TONE), groupSize,
+                                                     m_ampduLength[i], guardInterval).GetNanoSeconds ();
+    }
+}
+
+void
+MuGroupScorer::GatherAckDurations (const SuMuCostModel& costModel, HeRu::RuType ruType, std::size_t nUsers,
+                                   std::size_t nCentral26TonesRus, WifiAcknowledgment::Method ackMethod)
+{
+  std::size_t groupSize = nUsers + nCentral26TonesRus;
+
+  for (std::size_t i = 0; i < groupSize; i++)
+    {
+      m_ackDuration[i] = costModel.GetAckDuration (ackMethod, m_mcs[i], m_nss[i],
+                                                   (i < nUsers ? ruType : HeRu::RU_26_TONE),
+                                                   groupSize).GetNanoSeconds ();
+    }
+}
+
+void
+MuGroupScorer::Score (const SuMuCostModel& costModel, uint16_t channelWidth, uint16_t guardInterval,
+                      const std::vector<WifiAcknowledgment::Method>& ackMethods, uint32_t mpduSize,
+                      bool useCentral26TonesRus, double overhead)
+{
+  NS_ASSERT (!ackMethods.empty ());
+  std::size_t n = m_mcs.size ();
+
+  m_dataDuration.resize (n);
+  m_ackDuration.resize (n);
+  m_bits.resize (n + 1);
+  m_airtime.assign (n + 1, 0);
+  m_throughput.assign (n + 1, 0.0);
+  m_ruType.assign (n + 1, HeRu::RU_26_TONE);
+  m_ackMethod.assign (n + 1, ackMethods.front ());
+  m_bestGroupSize = 0;
+
+  m_bits[0] = 0.0;
+  for (std::size_t i = 0; i < n; i++)
+    {
+      m_bits[i + 1] = m_bits[i] + 8.0 * mpduSize * m_ampduLength[i];
+    }
+
+  for (std::size_t k = 1; k <= n; k++)
+    {
+      // only the values of k that equal the number of RUs of some type
+      // identify a group that is not identified by a smaller k
+      std::size_t nUsers = k;
+      std::size_t nCentral26TonesRus;
+      HeRu::RuType ruType = HeRu::GetEqualSizedRusForStations (channelWidth, nUsers, nCentral26TonesRus);
+      if (nUsers != k)
+        {
+          continue;
+        }
+      nCentral26TonesRus = (useCentral26TonesRus ? std::min (nCentral26TonesRus, n - k) : 0);
+      std::size_t groupSize = k + nCentral26TonesRus;
+
+      GatherDataDurations (costModel, ruType, k, nCentral26TonesRus, guardInterval);
+
+      // the DL MU PPDU lasts as long as the longest PSDU
+      int64_t dataDuration = 0;
+      for (std::size_t i = 0; i < groupSize; i++)
+        {
+          dataDuration = (m_dataDuration[i] > dataDuration ? m_dataDuration[i] : dataDuration);
+        }
+
+      // the ack sequence lasts as long as the slowest response
+      int64_t ackDuration = -1;
+      for (const auto& ackMethod : ackMethods)
+        {
+          GatherAckDurations (costModel, ruType, k, nCentral26TonesRus, ackMethod);
+          int64_t methodDuration = 0;
+          for (std::size_t i = 0; i < groupSize; i++)
+            {
+              methodDuration = (m_ackDuration[i] > methodDuration ? m_ackDuration[i] : methodDuration);
+            }
+          if (ackDuration < 0 || methodDuration < ackDuration)
+            {
+              ackDuration = methodDuration;
+              m_ackMethod[groupSize] = ackMethod;
+            }
+        }
+
+      m_airtime[groupSize] = dataDuration + ackDuration;
+      m_throughput[groupSize] = m_bits[groupSize] / (overhead + (dataDuration + ackDuration) / 1000.0);
+      m_ruType[groupSize] = ruType;
+
+      if (m_bestGroupSize == 0 || m_throughput[groupSize] > m_throughput[m_bestGroupSize])
+        {
+          m_bestGroupSize = groupSize;
+        }
+    }
+}
+
+std::size_t
+MuGroupScorer::GetBestGroupSize (void) const
+{
+  return m_bestGroupSize;
+}
+
+double
+MuGroupScorer::GetThroughput (std::size_t groupSize) const
+{
+  NS_ASSERT (groupSize < m_throughput.size ());
+  return m_throughput[groupSize];
+}
+
+uint32_t
+MuGroupScorer::GetBytes (std::size_t groupSize) const
+{
+  NS_ASSERT (groupSize < m_bits.size ());
+  return static_cast<uint32_t> (m_bits[groupSize] / 8);
+}
+
+Time
+MuGroupScorer::GetAirtime (std::size_t groupSize) const
+{
+  NS_ASSERT (groupSize < m_airtime.size ());
+  return NanoSeconds (m_airtime[groupSize]);
+}
+
+HeRu::RuType
+MuGroupScorer::GetRuType (std::size_t groupSize) const
+{
+  NS_ASSERT (groupSize < m_ruType.size ());
+  return m_ruType[groupSize];
+}
+
+WifiAcknowledgment::Method
+MuGroupScorer::GetAckMethod (std::size_t groupSize) const
+{
+  NS_ASSERT (groupSize < m_ackMethod.size ());
+  return m_ackMethod[groupSize];
+}
+
+} //namespace ns3
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MU_GROUP_SCORER_H
+#define MU_GROUP_SCORER_H
+
+#include "ns3/nstime.h"
+#include "ns3/wifi-acknowledgment.h"
+#include "he-ru.h"
+#include <vector>
+
+namespace ns3 {
+
+class SuMuCostModel;
+
+/**
+ * \ingroup wifi
+ *
+ * MuGroupScorer predicts the throughput of the DL MU PPDUs that can be sent to
+ * the first k candidate stations, for every k such that k stations can be
+ * allocated RUs of the same size (plus, optionally, the central 26-tone RUs
+ * that fit along with them), so that a scheduler can serve the group with
+ * the highest predicted throughput rather than either all the candidates or
+ * just one of them.
+ *
+ * Users are added in the order they would be allocated RUs. The MCS, the
+ * number of spatial streams and the A-MPDU length of the users are kept in contiguous arrays and every group is
+ * scored by branch-free reductions over those arrays, which the compiler can
+ * vectorize. Scratch arrays are reused across calls to Score, hence no memory
+ * is allocated once the scorer has seen the largest group.
+ */
+class MuGroupScorer
+{
+public:
+  MuGroupScorer ();
+
+  /**
+   * Remove all the users.
+   */
+  void Clear (void);
+  /**
+   * Add a user.
+   *
+   * \param mcs the HE MCS index used to transmit to the user
+   * \param nss the number of spatial streams used to transmit to the user
+   * \param ampduLength the number of MPDUs in the A-MPDU sent to the user
+   */
+  void AddUser (uint8_t mcs, uint8_t nss, uint16_t ampduLength);
+  /**
+   * \return the number of users
+   */
+  std::size_t GetNUsers (void) const;
+
+  /**
+   * Score all the groups that can be served by a DL MU PPDU.
+   *
+   * \param costModel the cost model, whose data table has been selected for the given MPDU size
+   * \param channelWidth the channel width in MHz
+   * \param guardInterval the guard interval in nanoseconds
+   * \param ackMethods the acknowledgment methods that can be used for DL MU
+   *        PPDUs (every group uses the one taking the least time)
+   * \param mpduSize the size in bytes of the aggregated MPDUs
+   * \param useCentral26TonesRus whether central 26-tone RUs can be allocated
+   * \param overhead the duration (microseconds) of the channel access and
+   *        padding overheads added to every frame exchange
+   */
+  void Score (const SuMuCostModel& costModel, uint16_t channelWidth, uint16_t guardInterval,
+              const std::vector<WifiAcknowledgment::Method>& ackMethods, uint32_t mpduSize,
+              bool useCentral26TonesRus,
+              double overhead);
+
+  /**
+   * \return the number of users of the group with the highest predicted
+   *         throughput (0 if there are no users)
+   */
+  std::size_t GetBestGroupSize (void) const;
+  /**
+   * \param groupSize the number of users of a group
+   * \return the predicted throughput (Mbps) of the group (zero if no DL MU PPDU
+   *         can be sent to exactly the given number of users)
+   */
+  double GetThroughput (std::size_t groupSize) const;
+  /**
+   * \param groupSize the number of users of a group
+   * \return the number of bytes sent to the users of the group
+   */
+  uint32_t GetBytes (std::size_t groupSize) const;
+  /**
+   * \param groupSize the number of users of a group
+   * \return the predicted duration of the DL MU PPDU and of the acknowledgment
+   *         sequence (zero if no DL MU PPDU can be sent to exactly the given
+   *         number of users)
+   */
+  Time GetAirtime (std::size_t groupSize) const;
+  /**
+   * \param groupSize the number of users of a group
+   * \return the type of the RUs (other than central 26-tone RUs) allocated to
+   *         the group
+   */
+  HeRu::RuType GetRuType (std::size_t groupSize) const;
+  /**
+   * \param groupSize the number of users of a group
+   * \return the acknowledgment method taking the least time for the group
+   */
+  WifiAcknowledgment::Method GetAckMethod (std::size_t groupSize) const;
+
+private:
+  /**
+   * Fill the per-user data duration array for the first nUsers users, which
+   * are allocated RUs of the given type, and the following nCentral26TonesRus
+   * users, which are allocated central 26-tone RUs.
+   *
+   * \param costModel the cost model
+   * \param ruType the RU type
+   * \param nUsers the number of users allocated RUs of the given type
+   * \param nCentral26TonesRus the number of users allocated central 26-tone RUs
+   * \param guardInterval the guard interval in nanoseconds
+   */
+  void GatherDataDurations (const SuMuCostModel& costModel, HeRu::RuType ruType, std::size_t nUsers,
+                            std::size_t nCentral26TonesRus, uint16_t guardInterval);
+  /**
+   * Fill the per-user ack duration array for the users of a group, given the
+   * acknowledgment method.
+   *
+   * \param costModel the cost model
+   * \param ruType the RU type allocated to the first nUsers users
+   * \param nUsers the number of users allocated RUs of the given type
+   * \param nCentral26TonesRus the number of users allocated central 26-tone RUs
+   * \param ackMethod the acknowledgment method
+   */
+  void GatherAckDurations (const SuMuCostModel& costModel, HeRu::RuType ruType, std::size_t nUsers,
+                           std::size_t nCentral26TonesRus, WifiAcknowledgment::Method ackMethod);
+
+  std::vector<uint8_t> m_mcs;              //!< MCS of every user
+  std::vector<uint8_t> m_nss;              //!< number of spatial streams of every user
+  std::vector<uint16_t> m_ampduLength;     //!< A-MPDU length of every user
+  std::vector<int64_t> m_dataDuration;     //!< scratch: PPDU duration (ns) needed by every user
+  std::vector<int64_t> m_ackDuration;      //!< scratch: ack sequence duration (ns) needed by every user
+  std::vector<double> m_bits;              //!< bits sent to the first k users, indexed by k
+  std::vector<int64_t> m_airtime;          //!< airtime (ns) of every group, indexed by group size
+  std::vector<double> m_throughput;        //!< throughput (Mbps) of every group, indexed by group size
+  std::vector<HeRu::RuType> m_ruType;      //!< RU type of every group, indexed by group size
+  std::vector<WifiAcknowledgment::Method> m_ackMethod; //!< ack method of every group, indexed by group size
+  std::size_t m_bestGroupSize;             //!< size of the group with the highest throughput
+};
+
+} //namespace ns3
+
+#endif /* MU_GROUP_SCORER_H */
@@ -19,6 +19,9 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/pointer.h"
 #include "rr-sumu-scheduler.h"
 #include "ns3/wifi-protection.h"
 #include "ns3/wifi-acknowledgment.h"
@@ -26,7 +29,10 @@
 #include "he-frame-exchange-manager.h"
 #include "he-configuration.h"
 #include "he-phy.h"
+#include "mpdu-aggregator.h"
+#include "wifi-utils.h"
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
@@ -87,12 +93,73 @@ RrsumuScheduler::GetTypeId (void)
                    UintegerValue (500),
                    MakeUintegerAccessor (&RrsumuScheduler::m_ulPsduSize),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AdaptiveDlAckSequence",
+                   "If enabled, the acknowledgment sequence of every DL MU PPDU is the one "
+                   "with the lowest predicted duration given the number of receivers, their "
+                   "RU and their MCS, rather than the one configured on the ack manager.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RrsumuScheduler::m_adaptiveDlAckSequence),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EnableUlSuMuSelection",
+                   "If enabled, an UL MU transmission is only solicited if the throughput "
+                   "predicted for the Basic Trigger Frame exchange exceeds the throughput "
+                   "predicted for the station with the largest buffer contending for the "
+                   "channel and transmitting an HE SU PPDU. Not soliciting the stations only "
+                   "results in UL SU transmissions if the stations are allowed to contend "
+                   "for the channel; disable this attribute otherwise.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&RrsumuScheduler::m_enableUlSuMuSelection),
+                   MakeBooleanChecker ())
+    .AddAttribute ("StaAifsn",
+                   "The AIFSN used by the stations to contend for the channel with the frames "
+                   "of the AC indicated as Preferred AC in the Basic Trigger Frames. Used to "
+                   "predict the throughput of UL SU transmissions.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&RrsumuScheduler::m_staAifsn),
+                   MakeUintegerChecker<uint8_t> (1, 15))
+    .AddAttribute ("StaCwMin",
+                   "The CWmin used by the stations to contend for the channel with the frames "
+                   "of the AC indicated as Preferred AC in the Basic Trigger Frames. Used to "
+                   "predict the throughput of UL SU transmissions.",
+                   UintegerValue (15),
+                   MakeUintegerAccessor (&RrsumuScheduler::m_staCwMin),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("UseCentral26TonesRus",
                    "If enabled, central 26-tone RUs are allocated, too, when the "
                    "selected RU type is at least 52 tones.",
                    BooleanValue (false),
                    MakeBooleanAccessor (&RrsumuScheduler::m_useCentral26TonesRus),
                    MakeBooleanChecker ())
+    .AddAttribute ("RuAllocation",
+                   "How RUs are allocated to the stations served by a DL MU PPDU: either RUs "
+                   "of the same size or RUs whose size depends on the bytes queued for the "
+                   "stations and their MCS, so that the durations of the PSDUs are balanced.",
+                   EnumValue (RrsumuScheduler::EQUAL_SIZE_RUS),
+                   MakeEnumAccessor (&RrsumuScheduler::m_ruAllocation),
+                   MakeEnumChecker (RrsumuScheduler::EQUAL_SIZE_RUS, "EqualSize",
+                                    RrsumuScheduler::BACKLOG_WEIGHTED_RUS, "BacklogWeighted"))
+    .AddAttribute ("SuAmpduEstimation",
+                   "How the length of the A-MPDU sent to the SU candidate is estimated: "
+                   "either by walking the queue of the candidate without modifying it, or "
+                   "by drawing from the lengths of the SU A-MPDUs recently sent to the "
+                   "candidate, which takes constant time but is less accurate.",
+                   EnumValue (RrsumuScheduler::QUEUE_WALK),
+                   MakeEnumAccessor (&RrsumuScheduler::m_suAmpduEstimation),
+                   MakeEnumChecker (RrsumuScheduler::QUEUE_WALK, "QueueWalk",
+                                    RrsumuScheduler::LEARNED_DISTRIBUTION, "LearnedDistribution"))
+    .AddAttribute ("SelectionPolicy",
+                   "The policy selecting between SU and DL MU transmissions. If not set, "
+                   "the format with the highest predicted throughput is selected.",
+                   PointerValue (),
+                   MakePointerAccessor (&RrsumuScheduler::m_selectionPolicy),
+                   MakePointerChecker<SuMuSelectionPolicy> ())
+    .AddAttribute ("EnableTxopPlanning",
+                   "If enabled, the PPDUs sent in a TXOP are planned when the TXOP starts, "
+                   "so that the bytes delivered in the TXOP are maximized: the first PPDU "
+                   "(SU or DL MU) may be followed by SU PPDUs to the candidates it does not serve.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RrsumuScheduler::m_enableTxopPlanning),
+                   MakeBooleanChecker ())
     .AddAttribute ("MaxCredits",
                    "Maximum amount of credits a station can have. When transmitting a DL MU PPDU, "
                    "the amount of credits received by each station equals the TX duration (in "
@@ -107,23 +174,61 @@ RrsumuScheduler::GetTypeId (void)
                    UintegerValue (4),
                    MakeUintegerAccessor (&RrsumuScheduler::num_stations),
                    MakeUintegerChecker<uint8_t> (1, 74))
+    .AddAttribute ("NominalPacketPadding",
+                   "The nominal packet padding of the stations (0, 8 or 16 us), which is "
+                   "the duration of the packet extension at the end of the HE PPDUs the AP "
+                   "sends them.",
+                   TimeValue (MicroSeconds (16)),
+                   MakeTimeAccessor (&RrsumuScheduler::m_nominalPacketPadding),
+                   MakeTimeChecker (MicroSeconds (0), MicroSeconds (16)))
     .AddAttribute ("Threshold",
-                    "threshold to decide SU tx or MU tx",
-                    UintegerValue (4),
-                      MakeDoubleAccessor (&RrsumuScheduler::threshold),
-                      MakeDoubleChecker<double> (0, 10000))
+                   "Width (in Mbps) of the hysteresis band around the SU/MU decision. If "
+                   "EnableHysteresis is true and the difference between the throughputs "
+                   "predicted for SU and MU at the last decision exceeded this value, the "
+                   "last decision is reused without evaluating the SU alternative, unless "
+                   "the candidate stations or the queue changed materially.",
+                   DoubleValue (4),
+                   MakeDoubleAccessor (&RrsumuScheduler::threshold),
+                   MakeDoubleChecker<double> (0, 10000))
+    .AddAttribute ("EnableHysteresis",
+                   "If enabled, reuse the last SU/MU decision as long as its predicted "
+                   "margin is outside the band set by the Threshold attribute.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RrsumuScheduler::m_enableHysteresis),
+                   MakeBooleanChecker ())
+    .AddAttribute ("HysteresisQueueChange",
+                   "Relative change in the number of packets queued by the AC that gained "
+                   "access above which the last SU/MU decision is no longer reused.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RrsumuScheduler::m_hysteresisQueueChange),
+                   MakeDoubleChecker<double> (0))
    .AddAttribute ("APqueue",
                    "Pointer to AP queue",
                     PointerValue(nullptr),
                       MakePointerAccessor (&RrsumuScheduler::que),
                      MakePointerChecker<UniformRandomVariable> ())
+    .AddTraceSource ("SuMuDecision",
+                     "An SU/MU decision has been taken. Nothing is computed for "
+                     "this trace source unless a sink is connected.",
+                     MakeTraceSourceAccessor (&RrsumuScheduler::m_decisionTrace),
+                     "ns3::SuMuDecisionRecord::TracedCallback")
+    .AddTraceSource ("SuMuSnapshot",
+                     "The inputs of an SU/MU selection and the selected format.",
+                     MakeTraceSourceAccessor (&RrsumuScheduler::m_snapshotTrace),
+                     "ns3::SuMuSnapshot::TracedCallback")
                      ;
   return tid;
 }
 
 
 RrsumuScheduler::RrsumuScheduler ()
-  : m_ulTriggerType (TriggerFrameType::BASIC_TRIGGER)
+  : m_muAckMethod (WifiAcknowledgment::DL_MU_BAR_BA_SEQUENCE),
+    m_ulTriggerType (TriggerFrameType::BASIC_TRIGGER),
+    m_durationCache (CreateObject<TxDurationCache> ()),
+    m_suAmpduDistribution (CreateObject<AmpduSizeDistribution> ()),
+    m_backlogIndex (CreateObject<BacklogIndex> ()),
+    m_bufferStatus (CreateObject<BufferStatusTracker> ()),
+    m_muAmpduHistory (CreateObject<AmpduHistory> ())
 {
   NS_LOG_FUNCTION (this);
 }
@@ -149,14 +254,27 @@ Ptr<WifiMacQueue> RrsumuScheduler:: getAPqueue(){
     return que;
 }
 
+Ptr<TxDurationCache>
+RrsumuScheduler::GetTxDurationCache (void) const
+{
+  return m_durationCache;
+}
+
+int64_t
+RrsumuScheduler::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  return m_suAmpduDistribution->AssignStreams (stream);
+}
+
 void
 RrsumuScheduler::DoInitialize (void)
 { 
    
-  /*Initialize the MU and SU AMPDU variables*/
+  /*Initialize the SU AMPDU variable*/
   
-  mu_ampdu = std::vector<int>(18, 7);
   su_ampdu = 0; 
+  m_costModel = CreateObject<SuMuCostModel> ();
 
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_apMac != nullptr);
@@ -164,24 +282,90 @@ RrsumuScheduler::DoInitialize (void)
                                        MakeCallback (&RrsumuScheduler::NotifyStationAssociated, this));
   m_apMac->TraceConnectWithoutContext ("DeAssociatedSta",
                                        MakeCallback (&RrsumuScheduler::NotifyStationDeassociated, this));
+  m_backlogIndex->TraceConnectWithoutContext ("EligibilityState",
+                                              MakeCallback (&RrsumuScheduler::NotifyEligibilityState, this));
   for (const auto& ac : wifiAcList)
     {
-      m_staList.insert ({ac.first, {}});
+      // keep the backlog index up to date
+      Ptr<QosTxop> qosTxop = m_apMac->GetQosTxop (ac.first);
+      for (const auto& queue : {qosTxop->GetWifiMacQueue (), qosTxop->GetBaManager ()->GetRetransmitQueue ()})
+        {
+          queue->TraceConnectWithoutContext ("Enqueue",
+                                             MakeCallback (&BacklogIndex::NotifyEnqueue, m_backlogIndex));
+          queue->TraceConnectWithoutContext ("Dequeue",
+                                             MakeCallback (&BacklogIndex::NotifyDequeue, m_backlogIndex));
+        }
+      qosTxop->GetBaManager ()->TraceConnectWithoutContext ("AgreementState",
+                                                            MakeCallback (&RrsumuScheduler::NotifyAgreementState, this));
     }
   MultiUserScheduler::DoInitialize ();
+  if (m_suAmpduEstimation == LEARNED_DISTRIBUTION)
+    {
+      m_heFem->TraceConnectWithoutContext ("PsduForwardDown",
+                                           MakeCallback (&RrsumuScheduler::NotifyPsduForwardedDown, this));
+    }
+  m_apMac->GetWifiPhy ()->TraceConnectWithoutContext ("MonitorSnifferRx",
+                                                       MakeCallback (&RrsumuScheduler::NotifyMpduReceived, this));
+  // cached TX durations referring to a previous PHY configuration are useless
+  m_durationCache->SetWifiPhy (m_apMac->GetWifiPhy ());
+  if (m_selectionPolicy == 0)
+    {
+      m_selectionPolicy = CreateObject<ThroughputSelectionPolicy> ();
+    }
+  m_selectionPolicy->Attach (m_apMac, m_heFem);
 }
 
 void
 RrsumuScheduler::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
-  m_staList.clear ();
+  m_stations.Clear ();
   m_candidates.clear ();
-  m_candidates2.clear (); 
 
   m_trigger = nullptr;
   m_txParams.Clear ();
   m_txParams2.Clear ();
+  if (m_costModel != 0)
+    {
+      m_costModel->Dispose ();
+      m_costModel = 0;
+    }
+  m_durationCache->Dispose ();
+  m_durationCache = 0;
+  if (m_heFem != 0 && m_suAmpduEstimation == LEARNED_DISTRIBUTION)
+    {
+      m_heFem->TraceDisconnectWithoutContext ("PsduForwardDown",
+                                              MakeCallback (&RrsumuScheduler::NotifyPsduForwardedDown, this));
+    }
+  if (m_selectionPolicy != 0)
+    {
+      m_selectionPolicy->Detach ();
+      m_selectionPolicy->Dispose ();
+      m_selectionPolicy = 0;
+    }
+  m_suAmpduDistribution->Dispose ();
+  m_suAmpduDistribution = 0;
+  m_muAmpduHistory->Dispose ();
+  m_muAmpduHistory = 0;
+  for (const auto& ac : wifiAcList)
+    {
+      Ptr<QosTxop> qosTxop = m_apMac->GetQosTxop (ac.first);
+      for (const auto& queue : {qosTxop->GetWifiMacQueue (), qosTxop->GetBaManager ()->GetRetransmitQueue ()})
+        {
+          queue->TraceDisconnectWithoutContext ("Enqueue",
+                                                MakeCallback (&BacklogIndex::NotifyEnqueue, m_backlogIndex));
+          queue->TraceDisconnectWithoutContext ("Dequeue",
+                                                MakeCallback (&BacklogIndex::NotifyDequeue, m_backlogIndex));
+        }
+      qosTxop->GetBaManager ()->TraceDisconnectWithoutContext ("AgreementState",
+                                                               MakeCallback (&RrsumuScheduler::NotifyAgreementState, this));
+    }
+  m_backlogIndex->Dispose ();
+  m_backlogIndex = 0;
+  m_apMac->GetWifiPhy ()->TraceDisconnectWithoutContext ("MonitorSnifferRx",
+                                                          MakeCallback (&RrsumuScheduler::NotifyMpduReceived, this));
+  m_bufferStatus->Dispose ();
+  m_bufferStatus = 0;
   m_apMac->TraceDisconnectWithoutContext ("AssociatedSta",
                                           MakeCallback (&RrsumuScheduler::NotifyStationAssociated, this));
   m_apMac->TraceDisconnectWithoutContext ("DeAssociatedSta",
@@ -193,9 +377,25 @@ MultiUserScheduler::TxFormat
 RrsumuScheduler::SelectTxFormat (void)
 {
   NS_LOG_FUNCTION (this); 
-  if (m_enableUlOfdma && m_enableBsrp && GetLastTxFormat () == DL_MU_TX)
+
+  // the receiver of an SU PPDU is only enforced if the PPDU has been planned
+  m_suReceiverAirtime = Seconds (0);
+
+  if (m_initialFrame)
+    {
+      // a new TXOP starts, hence the plan of the previous one is obsolete
+      m_txopPlan.clear ();
+    }
+  else if (!m_txopPlan.empty () && TrySendingPlannedSuPpdu () == SU_TX)
+    {
+      EnforceSuReceiver ();
+      return SU_TX;
+    }
+
+  // solicit buffer status reports only if the reports of the stations served
+  // by the last DL MU PPDU are stale
+  if (m_enableUlOfdma && m_enableBsrp && GetLastTxFormat () == DL_MU_TX && IsBufferStatusStale ())
     {
-        
       return TrySendingBsrpTf ();
     }
 
@@ -210,10 +410,14 @@ RrsumuScheduler::SelectTxFormat (void)
         }
     }
 
-  return TrySendingDlMuPpdu ();
+  TxFormat txFormat = TrySendingDlMuPpdu ();
+  if (txFormat == SU_TX)
+    {
+      EnforceSuReceiver ();
+    }
+  return txFormat;
 }
 
-//Not invoked*****
 MultiUserScheduler::TxFormat
 RrsumuScheduler::TrySendingBsrpTf (void)
 {
@@ -259,9 +463,9 @@ RrsumuScheduler::TrySendingBsrpTf (void)
   Time qosNullTxDuration = Seconds (0);
   for (const auto& userInfo : trigger)
     {
-      Time duration = WifiPhy::CalculateTxDuration (m_sizeOf8QosNull, txVector,
-                                                    m_apMac->GetWifiPhy ()->GetPhyBand (),
-                                                    userInfo.GetAid12 ());
+      Time duration = m_durationCache->CalculateTxDuration (m_sizeOf8QosNull, txVector,
+                                                            m_apMac->GetWifiPhy ()->GetPhyBand (),
+                                                            userInfo.GetAid12 ());
       qosNullTxDuration = Max (qosNullTxDuration, duration);
     }
 
@@ -300,7 +504,6 @@ RrsumuScheduler::TrySendingBsrpTf (void)
 }
 
 
-//Not invoked*****
 MultiUserScheduler::TxFormat
 RrsumuScheduler::TrySendingBasicTf (void)
 {
@@ -309,50 +512,40 @@ RrsumuScheduler::TrySendingBasicTf (void)
   // check if an UL OFDMA transmission is possible after a DL OFDMA transmission
   NS_ABORT_MSG_IF (m_ulPsduSize == 0, "The UlPsduSize attribute must be set to a non-null value");
   
-  //std::cout << "Preparing an UL_MU_OFDMA Tx" << std::endl;
 
   // determine which of the stations served in DL have UL traffic
   uint32_t maxBufferSize = 0;
-  // candidates sorted in decreasing order of queue size
-  std::multimap<uint8_t, CandidateInfo, std::greater<uint8_t>> ulCandidates;
+  // candidates sorted in decreasing order of buffer size
+  std::multimap<uint32_t, CandidateInfo, std::greater<uint32_t>> ulCandidates;
+  // bytes buffered by the candidates, indexed by AID
+  std::map<uint16_t, uint32_t> bufferSizes;
 
   for (const auto& candidate : m_candidates)
     {
-      uint8_t queueSize = m_apMac->GetMaxBufferStatus (candidate.first->address);
-      if (queueSize == 255)
-        {
-          NS_LOG_DEBUG ("Buffer status of station " << candidate.first->address << " is unknown");
-          //std::cout << "Buffer status of station " << candidate.first->address << " is unknown" << std::endl;
+      Mac48Address address = m_stations.GetAddress (candidate.first);
+      uint32_t bufferSize;
 
-          maxBufferSize = std::max (maxBufferSize, m_ulPsduSize);
-        }
-      else if (queueSize == 254)
+      if (!m_bufferStatus->HasReport (address))
         {
-          NS_LOG_DEBUG ("Buffer status of station " << candidate.first->address << " is not limited");
-          //std::cout << "Buffer status of station " << candidate.first->address << " is not limited" << std::endl;
-
-          maxBufferSize = 0xffffffff;
+          NS_LOG_DEBUG ("Buffer status of station " << address << " is unknown");
+          bufferSize = m_ulPsduSize;
         }
       else
         {
-          NS_LOG_DEBUG ("Buffer status of station " << candidate.first->address << " is " << +queueSize);
-          //std::cout << "Buffer status of station " << candidate.first->address << " is " << +queueSize << std::endl;
-
-          maxBufferSize = std::max (maxBufferSize, static_cast<uint32_t> (queueSize * 256));
+          // the reported buffer size, updated with the UL data received since
+          // the report and the data predicted to have arrived since then
+          bufferSize = m_bufferStatus->GetEstimate (address);
+          NS_LOG_DEBUG ("Predicted buffer status of station " << address << " is " << bufferSize
+                        << " bytes (reported " << +m_bufferStatus->GetLastReport (address) << ")");
         }
+      maxBufferSize = std::max (maxBufferSize, bufferSize);
+
       // serve the station if its queue size is not null
-      if (queueSize > 0)
+      if (bufferSize > 0)
         {
-          //std::cout << "Adding station " << candidate.first->aid << " to UL OFDMA candidate" << std::endl;
-          ulCandidates.emplace (queueSize, candidate);
+          bufferSizes[m_stations.GetAid (candidate.first)] = bufferSize;
+          ulCandidates.emplace (bufferSize, candidate);
         }
-      // else if ( queueSize == 0 ) { // Send Trigger regardless, during solicitation no data frame would be sent
-
-      //     std::cout << "Adding station " << candidate.first->aid << " to UL OFDMA candidate" << std::endl;
-
-      //     maxBufferSize = m_ulPsduSize;
-      //     ulCandidates.emplace (queueSize, candidate);
-      // }  
     }
 
   // if the maximum buffer size is 0, skip UL OFDMA and proceed with trying DL OFDMA
@@ -384,7 +577,7 @@ RrsumuScheduler::TrySendingBasicTf (void)
           for (std::size_t i = 0; i < count + nCentral26TonesRus; i++)
             {
               NS_ASSERT (candidateIt != ulCandidates.end ());
-              uint16_t staId = candidateIt->second.first->aid;
+              uint16_t staId = m_stations.GetAid (candidateIt->second.first);
               // AssignRuIndices will be called below to set RuSpec
               txVector.SetHeMuUserInfo (staId,
                                         {{(i < count ? ruType : HeRu::RU_26_TONE), 1, false},
@@ -405,7 +598,7 @@ RrsumuScheduler::TrySendingBasicTf (void)
           for (std::size_t i = 0; i < count + nCentral26TonesRus; i++)
             {
               NS_ASSERT (candidateIt != ulCandidates.end ());
-              uint16_t staId = candidateIt->second.first->aid;
+              uint16_t staId = m_stations.GetAid (candidateIt->second.first);
               auto userInfoIt = trigger.FindUserInfoWithAid (staId);
               NS_ASSERT (userInfoIt != trigger.end ());
               // AssignRuIndices will be called below to set RuSpec
@@ -429,7 +622,7 @@ RrsumuScheduler::TrySendingBasicTf (void)
       Mac48Address receiver = Mac48Address::GetBroadcast ();
       if (ulCandidates.size () == 1)
         {
-          receiver = ulCandidates.begin ()->second.first->address;
+          receiver = m_stations.GetAddress (ulCandidates.begin ()->second.first);
         }
 
       WifiMacHeader hdr (WIFI_MAC_CTL_TRIGGER);
@@ -453,7 +646,6 @@ RrsumuScheduler::TrySendingBasicTf (void)
           // an UL OFDMA transmission is not possible, hence return NO_TX. In
           // this way, no transmission will occur now and the next time we will
           // try again performing an UL OFDMA transmission.
-          //std::cout << "Remaining TXOP duration is not enough for UL MU exchange" << std::endl;
           NS_LOG_DEBUG ("Remaining TXOP duration is not enough for UL MU exchange");
           return NO_TX;
         }
@@ -472,7 +664,6 @@ RrsumuScheduler::TrySendingBasicTf (void)
                                           - m_txParams.m_acknowledgment->acknowledgmentTime);
           if (maxDuration.IsNegative ())
             {
-              //std::cout << "Remaining TXOP duration is not enough for UL MU exchange" << std::endl;
               NS_LOG_DEBUG ("Remaining TXOP duration is not enough for UL MU exchange");
               return NO_TX;
             }
@@ -482,9 +673,9 @@ RrsumuScheduler::TrySendingBasicTf (void)
       Time bufferTxTime = Seconds (0);
       for (const auto& userInfo : trigger)
         {
-          Time duration = WifiPhy::CalculateTxDuration (maxBufferSize, txVector,
-                                                        m_apMac->GetWifiPhy ()->GetPhyBand (),
-                                                        userInfo.GetAid12 ());
+          Time duration = m_durationCache->CalculateTxDuration (maxBufferSize, txVector,
+                                                                m_apMac->GetWifiPhy ()->GetPhyBand (),
+                                                                userInfo.GetAid12 ());
           bufferTxTime = Max (bufferTxTime, duration);
         }
 
@@ -500,9 +691,9 @@ RrsumuScheduler::TrySendingBasicTf (void)
           Time minDuration = Seconds (0);
           for (const auto& userInfo : trigger)
             {
-              Time duration = WifiPhy::CalculateTxDuration (m_ulPsduSize, txVector,
-                                                            m_apMac->GetWifiPhy ()->GetPhyBand (),
-                                                            userInfo.GetAid12 ());
+              Time duration = m_durationCache->CalculateTxDuration (m_ulPsduSize, txVector,
+                                                                    m_apMac->GetWifiPhy ()->GetPhyBand (),
+                                                                    userInfo.GetAid12 ());
               minDuration = (minDuration.IsZero () ? duration : Min (minDuration, duration));
             }
 
@@ -511,13 +702,18 @@ RrsumuScheduler::TrySendingBasicTf (void)
               // maxDuration is a too short time, hence return NO_TX. In this way,
               // no transmission will occur now and the next time we will try again
               // performing an UL OFDMA transmission.
-              //std::cout << "Available time " << maxDuration.As (Time::MS) << " is too short" << std::endl;
 
               NS_LOG_DEBUG ("Available time " << maxDuration.As (Time::MS) << " is too short");
               return NO_TX;
             }
         }
 
+      if (m_enableUlSuMuSelection && !IsUlOfdmaBetter (txVector, bufferSizes, maxDuration))
+        {
+          NS_LOG_DEBUG ("Letting the station with the largest buffer contend for an UL SU transmission");
+          return DL_MU_TX;
+        }
+
       // maxDuration is the time to grant to the stations. Finalize the Trigger Frame
       NS_LOG_DEBUG ("TB PPDU duration: " << maxDuration.As (Time::MS));
       trigger.SetUlLength (HePhy::ConvertHeTbPpduDurationToLSigLength (maxDuration,
@@ -547,13 +743,14 @@ RrsumuScheduler::NotifyStationAssociated (uint16_t aid, Mac48Address address)
 {
   NS_LOG_FUNCTION (this << aid << address);
 
-  if (GetWifiRemoteStationManager ()->GetHeSupported (address))
+  std::size_t slot = m_stations.Find (address);
+  if (slot != StationTable::NONE)
     {
-      for (auto& staList : m_staList)
-        {
-          staList.second.push_back (MasterInfo {aid, address, 0.0});
-        }
+      // the station reassociated
+      m_stations.Remove (slot);
     }
+  slot = m_stations.Add (aid, address, GetWifiRemoteStationManager ()->GetHeSupported (address));
+  m_stations.SetEligible (slot, m_backlogIndex->IsEligible (address));
 }
 
 void
@@ -561,37 +758,104 @@ RrsumuScheduler::NotifyStationDeassociated (uint16_t aid, Mac48Address address)
 {
   NS_LOG_FUNCTION (this << aid << address);
 
-  if (GetWifiRemoteStationManager ()->GetHeSupported (address))
+  std::size_t slot = m_stations.Find (address);
+  if (slot != StationTable::NONE && m_stations.GetAid (slot) == aid)
     {
-      for (auto& staList : m_staList)
-        {
-          staList.second.remove_if ([&aid, &address] (const MasterInfo& info)
-                                    { return info.aid == aid && info.address == address; });
-        }
+      m_stations.Remove (slot);
+      m_suAmpduDistribution->RemoveStation (address);
+      m_muAmpduHistory->RemoveStation (address);
+      m_backlogIndex->RemoveStation (address);
+      m_bufferStatus->RemoveStation (address);
     }
 }
 
-int 
-RrsumuScheduler::pickSuAmpduByProbability(const std::map<int, int>& valueCounts) {
-    // Extract keys and weights
-    std::vector<int> keys;
-    std::vector<int> weights;
+void
+RrsumuScheduler::NotifyEligibilityState (Mac48Address address, bool eligible)
+{
+  NS_LOG_FUNCTION (this << address << eligible);
 
-    for (const auto& pair : valueCounts) {
-        keys.push_back(pair.first);
-        weights.push_back(pair.second);
+  std::size_t slot = m_stations.Find (address);
+  if (slot != StationTable::NONE)
+    {
+      m_stations.SetEligible (slot, eligible);
     }
+}
 
-    // Create a random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::discrete_distribution<> dist(weights.begin(), weights.end());
+void
+RrsumuScheduler::NotifyAgreementState (Time now, Mac48Address recipient, uint8_t tid,
+                                       OriginatorBlockAckAgreement::State state)
+{
+  NS_LOG_FUNCTION (this << now << recipient << +tid << state);
+  m_backlogIndex->SetBaEstablished (recipient, tid, state == OriginatorBlockAckAgreement::ESTABLISHED);
+}
 
-    // Select an index based on the weights
-    int selectedIndex = dist(gen);
-    return keys[selectedIndex];
+void
+RrsumuScheduler::NotifyPsduForwardedDown (Ptr<const WifiPsdu> psdu, WifiTxVector txVector)
+{
+  NS_LOG_FUNCTION (this << *psdu << txVector);
+
+  // only learn from the SU A-MPDUs containing QoS data frames sent to a station
+  if (txVector.IsMu () || psdu->GetAddr1 ().IsGroup ()
+      || !psdu->GetHeader (0).IsQosData ())
+    {
+      return;
+    }
+
+  std::set<uint8_t> tids = psdu->GetTids ();
+  NS_ASSERT (!tids.empty ());
+  m_suAmpduDistribution->NotifyAmpdu (psdu->GetAddr1 (), *tids.begin (), psdu->GetNMpdus ());
 }
 
+void
+RrsumuScheduler::NotifyMpduReceived (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                                     MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId)
+{
+  NS_LOG_FUNCTION (this << packet << txVector << staId);
+
+  WifiMacHeader hdr;
+  packet->PeekHeader (hdr);
+
+  if (!hdr.IsQosData () || hdr.GetAddr1 () != m_apMac->GetAddress ()
+      || m_stations.Find (hdr.GetAddr2 ()) == StationTable::NONE)
+    {
+      return;
+    }
+
+  if (hdr.IsQosEosp ())
+    {
+      // the frame carries a Queue Size subfield, i.e., a new report, which
+      // already accounts for the data carried by the frame. The AP MAC stores
+      // the queue size once the PHY has notified the MAC of the reception
+      Simulator::ScheduleNow (&RrsumuScheduler::UpdateBufferStatus, this, hdr.GetAddr2 ());
+    }
+  else if (hdr.HasData ())
+    {
+      m_bufferStatus->NotifyUlData (hdr.GetAddr2 (), packet->GetSize () - hdr.GetSerializedSize ());
+    }
+}
+
+void
+RrsumuScheduler::UpdateBufferStatus (Mac48Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+
+  // every report refreshes the report time, even if the queue size did not
+  // change (e.g., a station under saturation keeps reporting 254)
+  m_bufferStatus->NotifyReport (address, m_apMac->GetMaxBufferStatus (address));
+}
+
+bool
+RrsumuScheduler::IsBufferStatusStale (void) const
+{
+  for (const auto& candidate : m_candidates)
+    {
+      if (m_bufferStatus->IsStale (m_stations.GetAddress (candidate.first)))
+        {
+          return true;
+        }
+    }
+  return false;
+}
 
 MultiUserScheduler::TxFormat
 RrsumuScheduler::TrySendingDlMuPpdu (void)
@@ -600,16 +864,21 @@ RrsumuScheduler::TrySendingDlMuPpdu (void)
 
   AcIndex primaryAc = m_edca->GetAccessCategory ();
 
-  if (m_staList[primaryAc].empty ())
+  // the candidates of the previous DL MU PPDU are no longer needed (they are
+  // used to solicit UL MU PPDUs) and the SU candidate is only valid for the
+  // access in which it is determined
+  m_candidates.clear ();
+
+  if (m_stations.GetNHeStations () == 0)
     {
       NS_LOG_DEBUG ("No HE stations associated: return SU_TX");
       return TxFormat::SU_TX;
     }
 
-  std::size_t count = std::min (static_cast<std::size_t> (m_nStations), m_staList[primaryAc].size ());
+  uint16_t bw = m_apMac->GetWifiPhy ()->GetChannelWidth ();
+  std::size_t count = std::min (static_cast<std::size_t> (m_nStations), m_stations.GetNHeStations ());
   std::size_t nCentral26TonesRus;
-  HeRu::RuType ruType = HeRu::GetEqualSizedRusForStations (m_apMac->GetWifiPhy ()->GetChannelWidth (), count,
-                                                           nCentral26TonesRus);
+  HeRu::RuType ruType = HeRu::GetEqualSizedRusForStations (bw, count, nCentral26TonesRus);
 
   // std::size_t count2 = 1
   // std::size_t nCentral26TonesRus_su;
@@ -654,18 +923,15 @@ RrsumuScheduler::TrySendingDlMuPpdu (void)
 
   m_txParams.Clear ();
   m_txParams.m_txVector.SetPreambleType (WIFI_PREAMBLE_HE_MU);
-  m_txParams.m_txVector.SetChannelWidth (m_apMac->GetWifiPhy ()->GetChannelWidth ());
+  m_txParams.m_txVector.SetChannelWidth (bw);
   m_txParams.m_txVector.SetGuardInterval (heConfiguration->GetGuardInterval ().GetNanoSeconds ());
   m_txParams.m_txVector.SetBssColor (heConfiguration->GetBssColor ());
 
  // '''
  // SU Configuration 
  // ''' 
+  // the TX vector of the SU alternative is set when the first candidate is found
   m_txParams2.Clear ();
-  m_txParams2.m_txVector.SetPreambleType (WIFI_PREAMBLE_HE_MU);
-  m_txParams2.m_txVector.SetChannelWidth (m_apMac->GetWifiPhy ()->GetChannelWidth ());
-  m_txParams2.m_txVector.SetGuardInterval (heConfiguration->GetGuardInterval ().GetNanoSeconds ());
-  m_txParams2.m_txVector.SetBssColor (heConfiguration->GetBssColor ());
 
  
  
@@ -677,36 +943,45 @@ RrsumuScheduler::TrySendingDlMuPpdu (void)
   
   // Time actualAvailableTime2 = (m_initialFrame2 ? Time::Min () : m_availableTime2);
 
-  // iterate over the associated stations until an enough number of stations is identified
-  auto staIt = m_staList[primaryAc].begin ();
-  m_candidates.clear ();
+  // only visit the stations having an eligible TID, in decreasing order of
+  // credits, until an enough number of stations is identified
+  CreditHeap::ActiveWalk stationIt (m_stations.GetCredits (primaryAc));
 
- // '''
- // SU Configuration 
- // ''' 
-  m_candidates2.clear(); 
-  
-  // std::cout<<"Hello1"<<std::endl;   
+  // The RUs tentatively assigned to the candidates, in order. These are the RUs
+  // that AssignRuIndices would assign, hence the TX parameters computed while
+  // scanning the candidates can be reused by ComputeDlMuInfo if the RU type
+  // does not change.
+  std::size_t nRusOfType = RuLayout::GetNRus (bw, ruType);
+  std::size_t nCandidateCentral26TonesRus = (nCentral26TonesRus > 0
+                                             ? RuLayout::GetNCentral26TonesRus (bw, ruType) : 0);
 
-  while (staIt != m_staList[primaryAc].end ()
+  while (!stationIt.IsDone ()
          && m_candidates.size () < std::max (static_cast<std::size_t> (m_nStations), count + nCentral26TonesRus))
         //&& m_candidates.size () < std::min (static_cast<std::size_t> (m_nStations), count + nCentral26TonesRus))
     {
-      NS_LOG_DEBUG ("Next candidate STA (MAC=" << staIt->address << ", AID=" << staIt->aid << ")");
-      //std::cout << "Next candidate STA (MAC=" << staIt->address << ", AID=" << staIt->aid << ")" << std::endl;
-
-      HeRu::RuType currRuType = (m_candidates.size () < count ? ruType : HeRu::RU_26_TONE);
+      std::size_t slot = stationIt.Get ();
+      uint16_t aid = m_stations.GetAid (slot);
+      Mac48Address address = m_stations.GetAddress (slot);
+      NS_LOG_DEBUG ("Next candidate STA (MAC=" << address << ", AID=" << aid << ")");
+
+      std::size_t ruPos = m_candidates.size ();
+      HeRu::RuSpec currRu = (ruPos < nRusOfType
+                             ? RuLayout::GetRu (bw, ruType, ruPos)
+                             : (ruPos < nRusOfType + nCandidateCentral26TonesRus
+                                ? RuLayout::GetCentral26TonesRu (bw, ruType, ruPos - nRusOfType)
+                                : HeRu::RuSpec {HeRu::RU_26_TONE, 1, false}));
       
       // check if the AP has at least one frame to be sent to the current station
       for (uint8_t tid : tids)
         {
           AcIndex ac = QosUtilsMapTidToAc (tid);
           NS_ASSERT (ac >= primaryAc);
-          // check that a BA agreement is established with the receiver for the
-          // considered TID, since ack sequences for DL MU PPDUs require block ack
-          if (m_apMac->GetQosTxop (ac)->GetBaAgreementEstablished (staIt->address, tid))
+          // check that the AP has frames for the receiver and the considered TID and
+          // that a BA agreement is established, since ack sequences for DL MU PPDUs
+          // require block ack
+          if (m_backlogIndex->IsEligible (address, tid))
             {
-              mpdu = m_apMac->GetQosTxop (ac)->PeekNextMpdu (tid, staIt->address);
+              mpdu = m_apMac->GetQosTxop (ac)->PeekNextMpdu (tid, address);
 
               // we only check if the first frame of the current TID meets the size
               // and duration constraints. We do not explore the queues further.
@@ -714,351 +989,750 @@ RrsumuScheduler::TrySendingDlMuPpdu (void)
               if (mpdu != 0)
                 {
                  
-                  // std::cout<<"Cannot create mpdu" <<std::endl; 
-                   // Use a temporary TX vector including only the STA-ID of the
-                  // candidate station to check if the MPDU meets the size and time limits.
-                  // An RU of the computed size is tentatively assigned to the candidate
-                  // station, so that the TX duration can be correctly computed.
-                  WifiTxVector suTxVector = GetWifiRemoteStationManager ()->GetDataTxVector (mpdu->GetHeader ()),
-                               txVectorCopy = m_txParams.m_txVector;
-
-                  m_txParams.m_txVector.SetHeMuUserInfo (staIt->aid,
-                                                         {{currRuType, 1, false},
+                  // Use the TX vector of an SU transmission to the candidate station to
+                  // determine its MCS and number of spatial streams. An RU is tentatively
+                  // assigned to the candidate station, so that the TX duration can be
+                  // correctly computed.
+                  WifiTxVector suTxVector = GetWifiRemoteStationManager ()->GetDataTxVector (mpdu->GetHeader ());
+                  m_stations.SetTxVector (slot, suTxVector);
+
+                  m_txParams.m_txVector.SetHeMuUserInfo (aid,
+                                                         {currRu,
                                                           suTxVector.GetMode (),
                                                           suTxVector.GetNss ()});
-                  
-                  WifiTxVector suTxVector2 = GetWifiRemoteStationManager ()->GetDataTxVector (mpdu->GetHeader ()),
-                               txVectorCopy2 = m_txParams2.m_txVector;
-                  
-                  m_txParams2.m_txVector.SetHeMuUserInfo (staIt->aid,
-                                                         {{currRuType, 1, false},
-                                                          suTxVector2.GetMode (),
-                                                          suTxVector2.GetNss ()});
-
-                                                        
-             
+
                   if (!m_heFem->TryAddMpdu (mpdu, m_txParams, actualAvailableTime))
                     {
                       NS_LOG_DEBUG ("Adding the peeked frame violates the time constraints");
-                      // std::cout << "Adding the peeked frame violates the time constraints" << std::endl;
-                      m_txParams.m_txVector = txVectorCopy;
-                      m_txParams2.m_txVector = txVectorCopy2;
-                      
+                      // TryAddMpdu left the TX parameters unchanged, hence it is
+                      // enough to undo the RU assignment
+                      m_txParams.m_txVector.GetHeMuUserInfoMap ().erase (aid);
                     }
                   else
                     {
                       // the frame meets the constraints
-                      NS_LOG_DEBUG ("Adding candidate STA (MAC=" << staIt->address << ", AID="
-                                    << staIt->aid << ") TID=" << +tid);
-                      m_candidates.push_back ({staIt, mpdu});
-                      m_candidates2.push_back ({staIt, mpdu});
-                      //std::cout << "Adding station " << staIt->aid << " to DL OFDMA candidates" << std::endl;
+                      NS_LOG_DEBUG ("Adding candidate STA (MAC=" << address << ", AID="
+                                    << aid << ") TID=" << +tid);
+                      if (m_candidates.empty ())
+                        {
+                          // the first candidate is the receiver of the SU alternative
+                          m_txParams2.m_txVector = suTxVector;
+                        }
+                      m_candidates.push_back ({slot, mpdu});
                       break;    // terminate the for loop
                     }
                 }
               else
                 {
-                  std::cout << "No frames to send to " << staIt->address << " with TID=" << +tid << std::endl;
-                  NS_LOG_DEBUG ("No frames to send to " << staIt->address << " with TID=" << +tid);
+                  NS_LOG_DEBUG ("No frames to send to " << address << " with TID=" << +tid);
                 }
             }
-            else {
-              //std::cout << "Block Agreement not established with station. for TID = " << +tid << std::endl;   
-            }
         }
 
-      // move to the next station in the list
-      staIt++;
+      // move to the next station in decreasing order of credits
+      stationIt.Next ();
     }
 
   if (m_candidates.empty ())
     {
       if (m_forceDlOfdma)
         {
-          std::cout << "No candidates left -- forced DL OFDMA" << std::endl;    
- 
           NS_LOG_DEBUG ("The AP does not have suitable frames to transmit: return NO_TX");
           return NO_TX;
         }
 
-      // std::cout << "No candidates left" << m_candidates.size()<< std::endl;   
       NS_LOG_DEBUG ("The AP does not have suitable frames to transmit: return SU_TX");
       return SU_TX;
     }
 
- 
-  // std::cout<<"Hello"<<std::endl;   
+  // check whether the last decision can be reused
+  std::vector<uint16_t> candidateAids;
+  candidateAids.reserve (m_candidates.size ());
+  for (const auto& candidate : m_candidates)
+    {
+      candidateAids.push_back (m_stations.GetAid (candidate.first));
+    }
+  std::sort (candidateAids.begin (), candidateAids.end ());
+  uint32_t nQueuedPackets = m_edca->GetWifiMacQueue ()->GetNPackets ();
 
+  if (m_enableHysteresis && m_selectionPolicy->CanReuseDecision ()
+      && CanReuseLastDecision (candidateAids, nQueuedPackets))
+    {
+      NS_LOG_DEBUG ("Reusing the last decision (margin=" << m_lastDecision.margin << " Mbps)");
+      // the predictions of the reused decision still hold
+      su_tpt = m_lastDecision.suThroughput;
+      mu_tpt = m_lastDecision.muThroughput;
+      TraceDecision (m_lastDecision.format, nQueuedPackets, m_lastDecision.suAirtime,
+                     m_lastDecision.muAirtime, m_lastDecision.muGroupSize, true);
+      if (m_lastDecision.format == DL_MU_TX)
+        {
+          // the candidates are the same, hence so are the group to serve and
+          // its ack sequence
+          m_candidates.resize (m_lastDecision.muGroupSize);
+          m_muAckMethod = m_lastDecision.muAckMethod;
+        }
+      return m_lastDecision.format;
+    }
 
+  // the throughput of both alternatives is estimated by using the size of the
+  // MPDU peeked for the first candidate station
+  mpdu_size = m_candidates.front ().second->GetSize ();
 
-  
-  // for (const auto& value : mu_ampdu) {
-  //   std::cout << value << std::endl;
-  // }
-     
-  std::cout << "MU Data Transmission Duration MU" << m_txParams.m_txDuration << std::endl;
-  std::cout << "MU Ack Transmission Duration MU" << m_txParams.m_acknowledgment->acknowledgmentTime << std::endl;  
-  
-  //Initialise MU TX data and Ack time values 
-  mu_txdata= m_txParams.m_txDuration; 
-  mu_Back= m_txParams.m_acknowledgment->acknowledgmentTime; 
-  
-  // MU Preamble duration 
-  WifiDlMuAggregateTf* dlMuAggrTfAcknowledgment = static_cast<WifiDlMuAggregateTf*> (m_txParams.m_acknowledgment.get ());
-  WifiTxVector* responseTxVector = nullptr;
-  responseTxVector = &dlMuAggrTfAcknowledgment->stationsReplyingWithBlockAck.begin ()->second.blockAckTxVector;
-  //std::cout << "Preamble  Duration ACKKK----------- MU" << m_apMac->GetWifiPhy()->CalculatePhyPreambleAndHeaderDuration (*responseTxVector)<<std::endl;
+  PrepareCostModel ();
+  m_costModel->SetMpduSize (mpdu_size);
 
-  mu_Pul= m_apMac->GetWifiPhy()->CalculatePhyPreambleAndHeaderDuration (*responseTxVector); 
-  
-  
-  su_ampdu = calculate_su_mpdu(); //calculate the SU AMPDU size 
-  // calculate_mu_mpdu(); //calculate the MU AMPDU size 
-  // ComputeDlMuInfo(); 
-  
-  std::cout<<"SU: AMPDU size: "<<su_ampdu<<std::endl;   
-  std::cout<<"Length of m_candidates "<<m_candidates.size()<<" Length of m_candidates2 "<<m_candidates2.size(); 
-  
-  std::cout<<"Total Packets"<<que->GetNPackets()<<std::endl;
-  std::cout<<"Maximum Size"<<que->GetMaxSize().GetValue()<<std::endl;
+  uint16_t gi = m_txParams.m_txVector.GetGuardInterval ();
+
+  // SU: the first candidate station is sent an HE SU PPDU occupying the
+  // whole channel (at the current channel width) and responds with a BlockAck
+  Time suAckDuration = m_costModel->GetSuAckDuration ();
+
+  su_ampdu = calculate_su_mpdu (suAckDuration); //calculate the SU AMPDU size 
   
-  //Retrieve single MPDU Size 
-if (mpdu != nullptr) {
-    try {
-        mpdu_size = mpdu->GetSize();
-    } 
-    catch (const std::exception& e) {
-        std::cerr << "Exception: " << e.what() << std::endl;
-    } 
-    catch (...) {
-        std::cerr << "Unknown exception occurred while getting MPDU size." << std::endl;
-    }
-} else {
-    // Pointer is null; no action needed
-}
+  NS_LOG_DEBUG ("SU A-MPDU size: " << su_ampdu << ", candidates: " << m_candidates.size ());
 
-  //MU Tx and Ack values 
-  double mu_Pdl_val =   mu_Pdl.GetMicroSeconds() ; 
-  double mu_txdata_val = mu_txdata.GetMicroSeconds() ; 
-  double mu_Pul_val = mu_Pul.GetMicroSeconds(); 
-  double mu_Back_val = mu_Back.GetMicroSeconds(); 
+  // the A-MPDU length is estimated as configured, while the airtime comes from
+  // the cost model, as for the other candidates
+  Time suAirtime = GetSuAirtime (m_candidates.front (), std::max<uint32_t> (su_ampdu, 1), gi);
 
+  // MU: every group made of the first k candidate stations that can be allocated
+  // RUs of the same size is scored and the group with the highest predicted
+  // throughput is the DL MU alternative. The A-MPDU length of every candidate
+  // is predicted from the PSDUs recently sent to that station in DL MU PPDUs
+  m_groupScorer.Clear ();
 
-  //SU Tx and Ack values 
-  double su_Pdl_val =   su_Pdl.GetMicroSeconds() ; 
-  double su_txdata_val = su_txdata.GetMicroSeconds() ; 
-  double su_Pul_val = su_Pul.GetMicroSeconds(); 
-  double su_Back_val = su_Back.GetMicroSeconds(); 
+  for (const auto& candidate : m_candidates)
+    {
+      uint16_t aid = m_stations.GetAid (candidate.first);
+      m_groupScorer.AddUser (m_txParams.m_txVector.GetMode (aid).GetMcsValue (), m_txParams.m_txVector.GetNss (aid),
+                             m_muAmpduHistory->GetAmpduLength (m_stations.GetAddress (candidate.first)));
+    }
 
-  
+  std::vector<WifiAcknowledgment::Method> ackMethods {m_txParams.m_acknowledgment->method};
+  if (m_adaptiveDlAckSequence)
+    {
+      ackMethods = {WifiAcknowledgment::DL_MU_BAR_BA_SEQUENCE,
+                    WifiAcknowledgment::DL_MU_TF_MU_BAR,
+                    WifiAcknowledgment::DL_MU_AGGREGATE_TF};
+    }
+  const MacOverheads& overheads = GetMacOverheads ();
+  Time accessTime = overheads.aifs + overheads.backoff;
+  m_groupScorer.Score (*m_costModel, bw, gi, ackMethods, mpdu_size, m_useCentral26TonesRus,
+                       (accessTime + overheads.pe + overheads.pe).ToDouble (Time::US));
+  std::size_t muGroupSize = m_groupScorer.GetBestGroupSize ();
+  Time muAirtime = m_groupScorer.GetAirtime (muGroupSize);
 
-  su_tpt = 8*mpdu_size*su_ampdu / (aifs + bo + su_Pdl_val + su_txdata_val +sifs+su_Pul_val +su_Back_val); 
-  
-  mu_tpt = 8*mpdu_size*std::accumulate(mu_ampdu.begin(), mu_ampdu.end(), 0) / (aifs + bo + mu_Pdl_val + mu_txdata_val + pe + sifs + mu_Pul_val + mu_Back_val + pe); 
+  double su_airtime_val = suAirtime.ToDouble (Time::US);
 
-  // double percentfilled = (1.0*que->GetNPackets())/que->GetMaxSize().GetValue();
-  // std::cout<<"Percent Filled"<<percentfilled<<std::endl;
- 
-  std::cout<< "Estimated    MU Tpt:   "<<mu_tpt<<"Mbps  SU Tpt:   "<<su_tpt<<"Mbps"<<std::endl; 
+  su_tpt = 8*m_suEstimate.nBytes / (accessTime.ToDouble (Time::US) + su_airtime_val); 
   
-  if(su_tpt > mu_tpt){
-    std::cout<<"Single User Transmission"<<std::endl;
-    return TxFormat::SU_TX;
-  }
-  std::cout<<"Multi User Transmission"<<std::endl;
+  mu_tpt = m_groupScorer.GetThroughput (muGroupSize);
+
+  NS_LOG_DEBUG ("Estimated MU throughput: " << mu_tpt << " Mbps (" << muGroupSize << " of "
+                << m_candidates.size () << " candidates, " << m_groupScorer.GetRuType (muGroupSize)
+                << " RUs), SU throughput: " << su_tpt << " Mbps");
+
+  SuMuSnapshot snapshot;
+  snapshot.candidates.reserve (m_candidates.size ());
+  for (const auto& candidate : m_candidates)
+    {
+      SuMuSnapshot::Candidate info;
+      info.address = m_stations.GetAddress (candidate.first);
+      info.aid = m_stations.GetAid (candidate.first);
+      info.tid = candidate.second->GetHeader ().GetQosTid ();
+      info.mpduSize = candidate.second->GetSize ();
+      info.mcs = m_txParams.m_txVector.GetMode (info.aid).GetMcsValue ();
+      info.ampduLength = m_muAmpduHistory->GetAmpduLength (info.address);
+      info.holDelay = Simulator::Now () - candidate.second->GetTimeStamp ();
+      // only the A-MPDU of the first candidate has been estimated as configured,
+      // the others are predicted from the backlog of the candidates
+      info.suAirtime = (snapshot.candidates.empty ()
+                        ? suAirtime
+                        : GetSuAirtime (candidate, GetBacklogAmpduLength (candidate), gi));
+      snapshot.candidates.push_back (info);
+    }
+  snapshot.availableTime = m_availableTime;
+  snapshot.nQueuedPackets = nQueuedPackets;
+  snapshot.queueCapacity = m_edca->GetWifiMacQueue ()->GetMaxSize ().GetValue ();
+  snapshot.accessTime = accessTime;
+  snapshot.suAirtime = suAirtime;
+  snapshot.suBytes = m_suEstimate.nBytes;
+  snapshot.suThroughput = su_tpt;
+  snapshot.muGroupSize = muGroupSize;
+  snapshot.muAirtime = muAirtime;
+  snapshot.muBytes = m_groupScorer.GetBytes (muGroupSize);
+  snapshot.muThroughput = mu_tpt;
+
+  if (m_enableTxopPlanning && m_initialFrame && m_availableTime.IsStrictlyPositive ())
+    {
+      // plan the sequence of PPDUs that delivers the most bytes in the TXOP
+      PlanTxop (suAirtime, gi);
+      snapshot.txopPlanned = true;
+      snapshot.plannedMuGroupSize = m_txopPlanner.GetMuGroupSize ();
+    }
+
+  TxFormat format = m_selectionPolicy->Select (snapshot);
+  NS_ASSERT (format == SU_TX || format == DL_MU_TX);
+
+  // the decision that can be reused is the one of the selection policy, since
+  // the TXOP plan only applies to the TXOP being started
+  m_lastDecision.format = format;
+  m_lastDecision.margin = std::abs (su_tpt - mu_tpt);
+  m_lastDecision.candidates = std::move (candidateAids);
+  m_lastDecision.nQueuedPackets = nQueuedPackets;
+  m_lastDecision.muGroupSize = muGroupSize;
+  m_lastDecision.muAckMethod = m_groupScorer.GetAckMethod (muGroupSize);
+  m_lastDecision.suAirtime = suAirtime;
+  m_lastDecision.muAirtime = muAirtime;
+  m_lastDecision.suThroughput = su_tpt;
+  m_lastDecision.muThroughput = mu_tpt;
+
+  if (snapshot.txopPlanned && (format == SU_TX) != (snapshot.plannedMuGroupSize == 0))
+    {
+      NS_LOG_DEBUG ("The selection policy overrides the TXOP plan");
+      m_txopPlan.clear ();
+    }
+  else if (snapshot.txopPlanned && format == DL_MU_TX)
+    {
+      // serve the group starting the plan
+      muGroupSize = snapshot.plannedMuGroupSize;
+      muAirtime = m_groupScorer.GetAirtime (muGroupSize);
+      mu_tpt = m_groupScorer.GetThroughput (muGroupSize);
+    }
+  else if (snapshot.txopPlanned)
+    {
+      // the SU PPDU starting the plan must be sent to the first candidate
+      m_suReceiverAirtime = suAirtime;
+    }
+
+  m_muAckMethod = m_groupScorer.GetAckMethod (muGroupSize);
+
+  TraceDecision (format, nQueuedPackets, suAirtime, muAirtime, muGroupSize, false);
+  m_snapshotTrace (snapshot, format);
+
+  if (format == SU_TX)
+    {
+      return TxFormat::SU_TX;
+    }
+
+  // the candidates not in the selected group are not served
+  m_candidates.resize (muGroupSize);
   return TxFormat::DL_MU_TX;
+}
+
+
+
+void
+RrsumuScheduler::PlanTxop (Time suAirtime, uint16_t guardInterval)
+{
+  NS_LOG_FUNCTION (this << suAirtime << guardInterval);
+
+  m_txopPlanner.Clear ();
+  AcIndex primaryAc = m_edca->GetAccessCategory ();
+  std::vector<PlannedSuPpdu> suPpdus;
+  suPpdus.reserve (m_candidates.size ());
+
+  for (const auto& candidate : m_candidates)
+    {
+      std::size_t index = suPpdus.size ();
+      uint8_t tid = candidate.second->GetHeader ().GetQosTid ();
+
+      if (index == 0)
+        {
+          suPpdus.push_back ({candidate.first, tid, suAirtime});
+          m_txopPlanner.AddSuPpdu (index, suAirtime, m_suEstimate.nBytes);
+          continue;
+        }
+
+      // the A-MPDU sent in an SU PPDU later in the TXOP is made of the frames
+      // queued for the candidate and the TID of the peeked frame, which must
+      // belong to the AC that gained access (TXOP sharing only applies to DL
+      // MU PPDUs)
+      uint16_t ampduLength = GetBacklogAmpduLength (candidate);
+      Time airtime = GetSuAirtime (candidate, ampduLength, guardInterval);
+      suPpdus.push_back ({candidate.first, tid, airtime});
+
+      if (QosUtilsMapTidToAc (tid) == primaryAc)
+        {
+          m_txopPlanner.AddSuPpdu (index, airtime, ampduLength * mpdu_size);
+        }
+    }
+
+  for (std::size_t groupSize = 1; groupSize <= m_candidates.size (); groupSize++)
+    {
+      Time airtime = m_groupScorer.GetAirtime (groupSize);
+      if (airtime.IsStrictlyPositive ())
+        {
+          m_txopPlanner.AddMuPpdu (groupSize, airtime + m_overheads.pe + m_overheads.pe,
+                                   m_groupScorer.GetBytes (groupSize));
+        }
+    }
+
+  m_txopPlanner.Plan (m_availableTime, m_apMac->GetWifiPhy ()->GetSifs ());
 
+  m_txopPlan.clear ();
+  for (std::size_t index : m_txopPlanner.GetSuBursts ())
+    {
+      m_txopPlan.push_back (suPpdus[index]);
+    }
+  m_txopPlanAc = primaryAc;
 
-  // if(percentfilled > 0.6){
-  //   std::cout<<"Single User Transmission"<<std::endl;
-  //   return TxFormat::SU_TX;
-  // }
-  // std::cout<<"Multi User Transmission"<<std::endl;
-  // return TxFormat::DL_MU_TX;
+  NS_LOG_DEBUG ("TXOP plan: " << (m_txopPlanner.GetMuGroupSize () > 0 ? "DL MU PPDU" : "SU PPDU")
+                << " followed by " << m_txopPlan.size () << " SU PPDUs, "
+                << m_txopPlanner.GetBytes () << " bytes");
 }
 
+MultiUserScheduler::TxFormat
+RrsumuScheduler::TrySendingPlannedSuPpdu (void)
+{
+  NS_LOG_FUNCTION (this);
 
+  AcIndex primaryAc = m_edca->GetAccessCategory ();
+  if (primaryAc != m_txopPlanAc)
+    {
+      m_txopPlan.clear ();
+      return NO_TX;
+    }
 
-int 
-RrsumuScheduler::calculate_su_mpdu(void){
+  m_candidates.clear ();
+
+  while (!m_txopPlan.empty ())
+    {
+      PlannedSuPpdu ppdu = m_txopPlan.front ();
+      m_txopPlan.pop_front ();
 
+      if (!m_stations.GetCredits (primaryAc).Contains (ppdu.slot))
+        {
+          // the station deassociated
+          continue;
+        }
 
-  if (m_candidates2.empty ())
+      if (m_availableTime != Time::Min () && ppdu.airtime > m_availableTime)
+        {
+          NS_LOG_DEBUG ("The planned SU PPDU (" << ppdu.airtime.As (Time::US) << ") does not fit in the "
+                        << "remaining TXOP (" << m_availableTime.As (Time::US) << "), dropping the plan");
+          m_txopPlan.clear ();
+          return NO_TX;
+        }
+
+      // the PPDU carries frames of the TID it has been planned for
+      Mac48Address address = m_stations.GetAddress (ppdu.slot);
+      Ptr<const WifiMacQueueItem> mpdu;
+      if (m_backlogIndex->IsEligible (address, ppdu.tid))
+        {
+          mpdu = m_edca->PeekNextMpdu (ppdu.tid, address);
+        }
+      if (mpdu == nullptr)
+        {
+          NS_LOG_DEBUG ("No frames left for the planned SU PPDU to " << address << " TID=" << +ppdu.tid);
+          continue;
+        }
+
+      NS_LOG_DEBUG ("Planned SU PPDU to " << address << " TID=" << +ppdu.tid);
+      m_txParams2.Clear ();
+      m_txParams2.m_txVector = GetWifiRemoteStationManager ()->GetDataTxVector (mpdu->GetHeader ());
+      m_stations.SetTxVector (ppdu.slot, m_txParams2.m_txVector);
+      m_candidates.push_back ({ppdu.slot, mpdu});
+      m_suReceiverAirtime = ppdu.airtime;
+      return SU_TX;
+    }
+  return NO_TX;
+}
+
+void
+RrsumuScheduler::EnforceSuReceiver (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_suReceiverAirtime.IsZero ())
     {
-      return 0; 
+      // the FEM sends the frames at the head of the queue
+      return;
     }
 
-  uint16_t bw = m_apMac->GetWifiPhy ()->GetChannelWidth ();
+  NS_ASSERT (!m_candidates.empty ());
+  const CandidateInfo& candidate = m_candidates.front ();
+  Ptr<const WifiMacQueueItem> mpdu = candidate.second;
 
-  // compute how many stations can be granted an RU and the RU size
-  std::size_t nRusAssigned = 1;
-  
-  std::size_t nCentral26TonesRus;
- 
+  if (QosUtilsMapTidToAc (mpdu->GetHeader ().GetQosTid ()) != m_edca->GetAccessCategory ())
+    {
+      NS_LOG_DEBUG ("The planned receiver has no frames of the AC that gained access");
+      m_txopPlan.clear ();
+      return;
+    }
 
-  HeRu::RuType ruType2 = HeRu::GetEqualSizedRusForStations (bw, nRusAssigned, nCentral26TonesRus);
+  // The FEM first sends a pending BlockAckReq, if any, and then builds the SU
+  // PSDU starting from the next MPDU of the AC, which is taken from the
+  // retransmit queue before the EDCA queue. Check that the FEM will send the
+  // planned PPDU before moving the MPDU peeked for the planned receiver to the
+  // head of its queue. Sequence numbers are assigned by the FEM, as usual
+  Mac48Address receiver = mpdu->GetHeader ().GetAddr1 ();
+  Ptr<const WifiMacQueueItem> next = m_edca->PeekNextMpdu ();
+  bool moveToHead = (next != nullptr && next->GetHeader ().GetAddr1 () != receiver);
+
+  if (m_edca->GetBaManager ()->GetBar (false) != nullptr
+      || next == nullptr
+      || (moveToHead && (!mpdu->IsQueued ()
+                         || !next->IsQueued ()
+                         || next->GetQueueIteratorPairs ().front ().queue != m_edca->GetWifiMacQueue ())))
+    {
+      // e.g., frames to retransmit to another station are sent first
+      NS_LOG_DEBUG ("The FEM will not send the planned SU PPDU, dropping the plan");
+      m_txopPlan.clear ();
+      return;
+    }
 
-  NS_LOG_DEBUG (nRusAssigned << " stations are being assigned a " << ruType2 << " RU");
-  std::cout << nRusAssigned << " stations are being assigned a " << ruType2 << " RU" << std::endl;
- 
-  if (!m_useCentral26TonesRus || m_candidates2.size () == nRusAssigned)
+  if (moveToHead)
     {
-      nCentral26TonesRus = 0;
+      WifiMacQueueItem::QueueIteratorPair queueIt = mpdu->GetQueueIteratorPairs ().front ();
+      Ptr<WifiMacQueueItem> item = queueIt.queue->Dequeue (queueIt.it);
+      NS_ASSERT (item == mpdu);
+      queueIt.queue->PushFront (item);
+      NS_ASSERT (m_edca->PeekNextMpdu () == mpdu);
     }
-  else
+
+  // the receiver is charged credits as if it were allocated the whole channel
+  // in a DL MU PPDU, so that it is not favored in the next channel accesses
+  CreditHeap& credits = m_stations.GetCredits (m_edca->GetAccessCategory ());
+  double airtime = m_suReceiverAirtime.ToDouble (Time::US);
+  credits.AddToAll (airtime / credits.GetSize ());
+  credits.ClampAbove (m_maxCredits.ToDouble (Time::US));
+  credits.Add (candidate.first, -airtime);
+}
+
+bool
+RrsumuScheduler::IsUlOfdmaBetter (const WifiTxVector& txVector, const std::map<uint16_t, uint32_t>& bufferSizes,
+                                  Time tbPpduDuration)
+{
+  NS_LOG_FUNCTION (this << txVector << tbPpduDuration);
+
+  // an A-MPDU cannot be larger than this (Table 9-19 of 802.11ax)
+  const uint32_t maxAmpduSize = 6500631;
+
+  PrepareCostModel ();
+  WifiPhyBand band = m_apMac->GetWifiPhy ()->GetPhyBand ();
+
+  // UL MU: the stations solicited by the Basic Trigger Frame send as many
+  // bytes as fit in the TB PPDU and are acknowledged by a Multi-STA BlockAck.
+  // The frame exchange takes place in the TXOP of the AP.
+  Time tbPreamble = m_durationCache->CalculatePhyPreambleAndHeaderDuration (txVector);
+  double muBytes = 0;
+  uint16_t heaviestAid = 0;
+  uint32_t heaviestBytes = 0;
+
+  for (const auto& buffer : bufferSizes)
     {
-      nCentral26TonesRus = std::min (m_candidates2.size () - nRusAssigned, nCentral26TonesRus);
-      NS_LOG_DEBUG (nCentral26TonesRus << " stations are being assigned a 26-tones RU");
-      //std::cout << nCentral26TonesRus << " stations are being assigned a 26-tones RU" << std::endl;
+      if (!txVector.GetHeMuUserInfoMap ().count (buffer.first))
+        {
+          // the station has not been allocated an RU
+          continue;
+        }
+      uint32_t bytes = std::min (buffer.second, maxAmpduSize);
+      Time duration = m_durationCache->CalculateTxDuration (bytes, txVector, band, buffer.first);
+      muBytes += (duration <= tbPpduDuration
+                  ? bytes
+                  : bytes * (tbPpduDuration - tbPreamble).GetSeconds () / (duration - tbPreamble).GetSeconds ());
+      if (buffer.second > heaviestBytes)
+        {
+          heaviestAid = buffer.first;
+          heaviestBytes = buffer.second;
+        }
     }
-  // std::cout<<"before dlMuInfo2 initialization" <<std::endl; 
-  
-  nCentral26TonesRus = 0;
 
-  DlMuInfo dlMuInfo2;
+  if (heaviestAid == 0)
+    {
+      return true;
+    }
 
-  // We have to update the TXVECTOR
-  dlMuInfo2.txParams.m_txVector.SetPreambleType (m_txParams2.m_txVector.GetPreambleType ());
-  dlMuInfo2.txParams.m_txVector.SetChannelWidth (m_txParams2.m_txVector.GetChannelWidth ());
-  dlMuInfo2.txParams.m_txVector.SetGuardInterval (m_txParams2.m_txVector.GetGuardInterval ());
-  dlMuInfo2.txParams.m_txVector.SetBssColor (m_txParams2.m_txVector.GetBssColor ());
+  Time protectionTime = (m_txParams.m_protection && m_txParams.m_protection->protectionTime != Time::Min ()
+                         ? m_txParams.m_protection->protectionTime : Seconds (0));
+  Time ackTime = (m_txParams.m_acknowledgment && m_txParams.m_acknowledgment->acknowledgmentTime != Time::Min ()
+                  ? m_txParams.m_acknowledgment->acknowledgmentTime : Seconds (0));
+  Time muAirtime = protectionTime + m_txParams.m_txDuration + m_apMac->GetWifiPhy ()->GetSifs ()
+                   + tbPpduDuration + ackTime;
+
+  // UL SU: the station with the largest buffer contends for the channel and
+  // sends an HE SU PPDU occupying the whole channel at its UL MCS
+  WifiTxVector suTxVector;
+  suTxVector.SetPreambleType (WIFI_PREAMBLE_HE_SU);
+  suTxVector.SetChannelWidth (txVector.GetChannelWidth ());
+  suTxVector.SetGuardInterval (m_apMac->GetHeConfiguration ()->GetGuardInterval ().GetNanoSeconds ());
+  suTxVector.SetMode (txVector.GetMode (heaviestAid));
+  suTxVector.SetNss (txVector.GetNss (heaviestAid));
+
+  uint32_t suBytes = std::min (heaviestBytes, maxAmpduSize);
+  Time suDuration = m_durationCache->CalculateTxDuration (suBytes, suTxVector, band);
+  Time maxSuDuration = GetPpduMaxTime (WIFI_PREAMBLE_HE_SU);
+  double suDeliveredBytes = suBytes;
+  if (suDuration > maxSuDuration)
+    {
+      Time suPreamble = m_durationCache->CalculatePhyPreambleAndHeaderDuration (suTxVector);
+      suDeliveredBytes = suBytes * (maxSuDuration - suPreamble).GetSeconds () / (suDuration - suPreamble).GetSeconds ();
+      suDuration = maxSuDuration;
+    }
+  // the station contends for the channel with its own EDCA parameters, which
+  // may differ from the ones used by the AP
+  Ptr<WifiPhy> phy = m_apMac->GetWifiPhy ();
+  Time staAifs = phy->GetSifs () + phy->GetSlot () * static_cast<int64_t> (m_staAifsn);
+  Time staBackoff = phy->GetSlot () * static_cast<int64_t> (m_staCwMin) / 2;
+  double suAirtime = (staAifs + staBackoff + suDuration
+                      + m_costModel->GetSuAckDuration ()).ToDouble (Time::US);
+
+  double ulMuTpt = 8 * muBytes / muAirtime.ToDouble (Time::US);
+  double ulSuTpt = 8 * suDeliveredBytes / suAirtime;
+
+  NS_LOG_DEBUG ("Estimated UL MU throughput: " << ulMuTpt << " Mbps (" << bufferSizes.size ()
+                << " stations), UL SU throughput: " << ulSuTpt << " Mbps (AID=" << heaviestAid << ")");
+  return ulMuTpt >= ulSuTpt;
+}
 
-  CandidateInfo candidate_su = m_candidates2.front();  // iterator over the list of candidate receivers
-  // std::cout<<"after dlMuInfo2 initialization" <<std::endl; 
+bool
+RrsumuScheduler::CanReuseLastDecision (const std::vector<uint16_t>& candidateAids,
+                                       uint32_t nQueuedPackets) const
+{
+  NS_LOG_FUNCTION (this << nQueuedPackets);
 
-  uint16_t staId = candidate_su.first->aid;
-    // AssignRuIndices will be called below to set RuSpec
-    dlMuInfo2.txParams.m_txVector.SetHeMuUserInfo (staId,
-                                                  {{(HeRu::RU_484_TONE), 1, false},
-                                                    m_txParams2.m_txVector.GetMode (staId),
-                                                    m_txParams2.m_txVector.GetNss (staId)});
-    
+  if (m_lastDecision.format == NO_TX)
+    {
+      NS_LOG_DEBUG ("No previous decision");
+      return false;
+    }
+  if (m_lastDecision.margin <= threshold)
+    {
+      NS_LOG_DEBUG ("The margin of the last decision is within the hysteresis band");
+      return false;
+    }
+  if (candidateAids != m_lastDecision.candidates)
+    {
+      NS_LOG_DEBUG ("The set of candidate stations changed");
+      return false;
+    }
 
-  // remove candidates that will not be served
-  // m_candidates2.erase (candidateIt, m_candidates2.end ());
+  double queueChange = std::abs (static_cast<double> (nQueuedPackets)
+                                 - static_cast<double> (m_lastDecision.nQueuedPackets));
+  if (queueChange > m_hysteresisQueueChange * std::max<uint32_t> (m_lastDecision.nQueuedPackets, 1))
+    {
+      NS_LOG_DEBUG ("The number of queued packets changed from " << m_lastDecision.nQueuedPackets
+                    << " to " << nQueuedPackets);
+      return false;
+    }
+  return true;
+}
 
-  AssignRuIndices (dlMuInfo2.txParams.m_txVector);
-  m_txParams2.Clear ();
+void
+RrsumuScheduler::TraceDecision (TxFormat format, uint32_t nQueuedPackets, Time suDuration,
+                                Time muDuration, std::size_t muGroupSize, bool reused)
+{
+  if (m_decisionTrace.IsEmpty ())
+    {
+      return;
+    }
 
-  Ptr<const WifiMacQueueItem> mpdu2;
+  SuMuDecisionRecord record;
+  record.timeNs = Simulator::Now ().GetNanoSeconds ();
+  record.suDurationNs = suDuration.GetNanoSeconds ();
+  record.muDurationNs = muDuration.GetNanoSeconds ();
+  record.suThroughput = su_tpt;
+  record.muThroughput = mu_tpt;
+  record.nQueuedPackets = nQueuedPackets;
+  record.nCandidates = m_candidates.size ();
+  record.suAmpduLength = su_ampdu;
+  record.format = format;
+  record.reused = reused;
+  record.muGroupSize = muGroupSize;
+  if (!m_candidates.empty ())
+    {
+      m_stations.GetAddress (m_candidates.front ().first).CopyTo (record.suReceiver);
+    }
+  m_decisionTrace (record);
+}
 
-  // Compute the TX params (again) by using the stored MPDUs and the final TXVECTOR
-  Time actualAvailableTime2 = (m_initialFrame ? Time::Min () : m_availableTime2);
+int 
+RrsumuScheduler::calculate_su_mpdu (Time responseTime)
+{
+  NS_LOG_FUNCTION (this << responseTime);
 
-  
-  
-  mpdu2 = candidate_su.second;
-  NS_ASSERT (mpdu2 != nullptr);
+  m_suEstimate = {0, 0, 0, Seconds (0)};
 
-  // std::cout<<"The available time for SU Transmission is "<<actualAvailableTime2<<std::endl; 
-  bool ret = m_heFem->TryAddMpdu (mpdu2, dlMuInfo2.txParams, actualAvailableTime2);
-  NS_UNUSED (ret);
-  NS_ASSERT_MSG (ret, "Weird that an MPDU does not meet constraints when "
-                          "transmitted over a larger RU");
-    
+  if (m_candidates.empty ())
+    {
+      return 0; 
+    }
 
-  // We have to complete the PSDUs to send
-  Ptr<WifiMacQueue> queue;
-  Mac48Address receiver2;
+  const CandidateInfo& candidate = m_candidates.front ();
+  Ptr<const WifiMacQueueItem> mpdu = candidate.second;
+  uint8_t tid = mpdu->GetHeader ().GetQosTid ();
 
-  // std::ostringstream oss;
-  // oss << "rr_aggregation_log_same1000.txt";
-  
-  // std::ofstream file;
-  // file.open(oss.str(), std::ios_base::app | std::ios_base::out);
+  if (m_suAmpduEstimation == QUEUE_WALK)
+    {
+      // walk the queue without dequeuing frames or assigning sequence numbers
+      m_suEstimate = EstimateSuAmpdu (mpdu, m_txParams2.m_txVector, m_availableTime, responseTime);
+      return m_suEstimate.nMpdus;
+    }
 
-  // oss.str("");
-  // oss.clear();
+  // draw the length from the distribution learned for the candidate station;
+  // the duration is left to the cost model
+  m_suEstimate.nMpdus = m_suAmpduDistribution->Sample (m_stations.GetAddress (candidate.first), tid);
+  m_suEstimate.nBytes = m_suEstimate.nMpdus * mpdu->GetSize ();
+  return m_suEstimate.nMpdus;
+}
 
-  // file << "======= SCHEDULER BEGINS AGGREGATION ========\n";
+RrsumuScheduler::SuAmpduEstimate
+RrsumuScheduler::EstimateSuAmpdu (Ptr<const WifiMacQueueItem> mpdu, const WifiTxVector& txVector,
+                                  Time availableTime, Time responseTime)
+{
+  NS_LOG_FUNCTION (this << *mpdu << txVector << availableTime << responseTime);
+  NS_ASSERT (mpdu->GetHeader ().IsQosData ());
+  NS_ASSERT (mpdu->IsQueued ());
+
+  Mac48Address receiver = mpdu->GetHeader ().GetAddr1 ();
+  uint8_t tid = mpdu->GetHeader ().GetQosTid ();
+  Ptr<QosTxop> qosTxop = m_apMac->GetQosTxop (QosUtilsMapTidToAc (tid));
+  WifiPhyBand band = m_apMac->GetWifiPhy ()->GetPhyBand ();
+
+  uint32_t maxAmpduSize = m_heFem->GetMpduAggregator ()->GetMaxAmpduSize (receiver, tid,
+                                                                           txVector.GetModulationClass ());
+  Time ppduMaxTime = GetPpduMaxTime (txVector.GetPreambleType ());
+
+  // the transmit window of the BA agreement, if any
+  bool baEstablished = qosTxop->GetBaAgreementEstablished (receiver, tid);
+  uint16_t winStart = (baEstablished ? qosTxop->GetBaStartingSequence (receiver, tid) : 0);
+  uint16_t winSize = (baEstablished ? qosTxop->GetBaBufferSize (receiver, tid) : 1);
+  // sequence number that would be assigned to the next new MPDU
+  uint16_t nextSeqNo = qosTxop->PeekNextSequenceNumberFor (&mpdu->GetHeader ());
+
+  SuAmpduEstimate estimate {0, 0, 0, Seconds (0)};
+  WifiMacQueueItem::QueueIteratorPair queueIt = mpdu->GetQueueIteratorPairs ().front ();
+  Ptr<const WifiMacQueueItem> item = mpdu;
+
+  while (item != nullptr)
+    {
+      // MPDUs that are retransmitted keep their sequence number
+      uint16_t seqNo = (item->GetHeader ().IsRetry () ? item->GetHeader ().GetSequenceNumber ()
+                                                      : nextSeqNo);
 
-     
+      if (estimate.nMpdus > 0 && !IsInWindow (seqNo, winStart, winSize))
+        {
+          NS_LOG_DEBUG ("MPDU beyond the end of the transmit window");
+          break;
+        }
 
-        // Let us try first A-MSDU aggregation if possible
-      // mpdu2 = candidate_su.second;
-      // std::cout<<"SU : This is the MPDU: " << mpdu2 <<std::endl; 
-
-      // NS_ASSERT (mpdu2 != nullptr);
-      // uint8_t tid = mpdu2->GetHeader ().GetQosTid ();
-      // receiver2 = mpdu2->GetHeader ().GetAddr1 ();
-      // NS_ASSERT (receiver2 == candidate_su.first->address);
-
-      // NS_ASSERT (mpdu2->IsQueued ());
-      // WifiMacQueueItem::QueueIteratorPair queueIt2 = mpdu2->GetQueueIteratorPairs ().front ();
-      // NS_ASSERT (queueIt2.queue != nullptr);
-      // Ptr<WifiMacQueueItem> item2 = *queueIt2.it;
-      // queueIt2.it++;
-
-      // if (!mpdu2->GetHeader ().IsRetry ())
-      //   {
-      //     // this MPDU must have been dequeued from the AC queue and we can try
-      //     // A-MSDU aggregation
-      //     item2 = m_heFem->GetMsduAggregator ()->GetNextAmsdu (mpdu2, dlMuInfo2.txParams, actualAvailableTime2, queueIt2);
-
-      //     if (item2 == nullptr)
-      //       {
-      //         // A-MSDU aggregation failed or disabled
-      //         item2 = *mpdu2->GetQueueIteratorPairs ().front ().it;
-      //       }
-      //     m_apMac->GetQosTxop (QosUtilsMapTidToAc (tid))->AssignSequenceNumber (item2);
-      //   }
-
-      // // Now, let's try A-MPDU aggregation if possible
-      // std::vector<Ptr<WifiMacQueueItem>> mpduList2 = m_heFem->GetMpduAggregator ()->GetNextAmpdu (item2, dlMuInfo2.txParams, actualAvailableTime2, queueIt2);
-
-      // // if ( mpduList2.size() > 0 )
-      // //   std::cout << "STA_" << candidate.first->aid << " is being sent an A-MPDU of size " << mpduList2.size() << " after aggregation" << std::endl;
-      // if (mpduList2.size () > 1)
-      //   {
-      //     //file << "STA_" << candidate.first->aid << " assigned a PSDU of size " << mpduList.size() << " after aggregation\n";
-      //     std::cout<<"SU Aggregation successful"<<std::endl; 
-      //     // A-MPDU aggregation succeeded, update psduMap
-      //     dlMuInfo2.psduMap[candidate_su.first->aid] = Create<WifiPsdu> (std::move (mpduList2));
-      //   }
-      // else
-      //   {
-
-      //     //file << "STA_" << candidate.first->aid << " assigned a PSDU of size " << mpduList.size() << " without aggregation\n";
-      //     std::cout<<"SU Aggregration failed"<<std::endl; 
-      //     dlMuInfo2.psduMap[candidate_su.first->aid] = Create<WifiPsdu> (item2, true); 
-      //   }
-        
-      //   size_t queueSize = queueIt2.queue->GetNPackets();
-      //   std::cout<<"SU Queue Size is: " << queueSize <<std::endl; 
+      uint32_t ampduSize = MpduAggregator::GetSizeIfAggregated (item->GetSize (), estimate.ampduSize);
+      Time duration = m_durationCache->CalculateTxDuration (ampduSize, txVector, band);
 
-      //   size_t ampduSize = dlMuInfo2.psduMap[candidate_su.first->aid]->GetNMpdus();
-      //   std::cout << "For SU -- STA_" << candidate_su.first->aid << " is being sent an A-MPDU of size " << ampduSize << " after aggregation" << std::endl;
-     
+      // the first MPDU is always sent, even if it exceeds the TXOP limit
+      if (estimate.nMpdus > 0
+          && (ampduSize > maxAmpduSize
+              || duration > ppduMaxTime
+              || (availableTime != Time::Min () && duration + responseTime > availableTime)))
+        {
+          NS_LOG_DEBUG ("Adding the next MPDU violates the size or time constraints");
+          break;
+        }
+
+      estimate.nMpdus++;
+      estimate.nBytes += item->GetSize ();
+      estimate.ampduSize = ampduSize;
+      estimate.duration = duration;
 
-    std::cout << "SU Data Transmission Duration SU" << dlMuInfo2.txParams.m_txDuration << std::endl;
-    std::cout << "SU Ack Transmission Duration SU" << dlMuInfo2.txParams.m_acknowledgment->acknowledgmentTime << std::endl;
-    
-    //Initialize SU Tx data duration and Ack duration 
-    su_txdata = dlMuInfo2.txParams.m_txDuration; 
-    su_Back = dlMuInfo2.txParams.m_acknowledgment->acknowledgmentTime; 
+      if (!item->GetHeader ().IsRetry ())
+        {
+          nextSeqNo = (nextSeqNo + 1) % SEQNO_SPACE_SIZE;
+        }
+      if (maxAmpduSize == 0)
+        {
+          // A-MPDU aggregation disabled
+          break;
+        }
+
+      // peek the next MPDU with the same receiver and TID
+      queueIt.it++;
+      item = qosTxop->PeekNextMpdu (queueIt, tid, receiver);
+      if (item != nullptr)
+        {
+          queueIt = item->GetQueueIteratorPairs ().front ();
+        }
+    }
 
-    // std::cout << "Preamble  Duration -----------" << m_apMac->GetWifiPhy()->CalculatePhyPreambleAndHeaderDuration (m_txParams.m_txVector)<<std::endl; 
-    
-    //Initialize MU and SU Downlink Preamble Duration 
-    // mu_Pdl = m_apMac->GetWifiPhy()->CalculatePhyPreambleAndHeaderDuration (m_txParams.m_txVector); 
-    su_Pdl = m_apMac->GetWifiPhy()->CalculatePhyPreambleAndHeaderDuration (dlMuInfo2.txParams.m_txVector); 
+  NS_LOG_DEBUG ("Estimated SU A-MPDU to " << receiver << ": " << estimate.nMpdus << " MPDUs, "
+                << estimate.nBytes << " bytes, " << estimate.duration);
+  return estimate;
+}
 
+uint16_t
+RrsumuScheduler::GetBacklogAmpduLength (const CandidateInfo& candidate) const
+{
+  Mac48Address address = m_stations.GetAddress (candidate.first);
+  uint8_t tid = candidate.second->GetHeader ().GetQosTid ();
+  uint32_t nPackets = std::max<uint32_t> (m_backlogIndex->GetBacklog (address, tid).packets, 1);
+  uint32_t maxLength = m_costModel->GetMaxAmpduLength ();
 
-    WifiDlMuAggregateTf* dlMuAggrTfAcknowledgment2 = static_cast<WifiDlMuAggregateTf*> (dlMuInfo2.txParams.m_acknowledgment.get ());
-    WifiTxVector* responseTxVector2 = nullptr;
-    responseTxVector2 = &dlMuAggrTfAcknowledgment2->stationsReplyingWithBlockAck.begin ()->second.blockAckTxVector;
-    //std::cout << "Preamble  Duration ACKKK -----------SU" << m_apMac->GetWifiPhy()->CalculatePhyPreambleAndHeaderDuration (*responseTxVector2)<<std::endl;
-      
-    su_Pul = m_apMac->GetWifiPhy()->CalculatePhyPreambleAndHeaderDuration (*responseTxVector2); 
+  Ptr<QosTxop> qosTxop = m_apMac->GetQosTxop (QosUtilsMapTidToAc (tid));
+  if (qosTxop->GetBaAgreementEstablished (address, tid))
+    {
+      maxLength = std::min<uint32_t> (maxLength, qosTxop->GetBaBufferSize (address, tid));
+    }
+  return static_cast<uint16_t> (std::min (nPackets, maxLength));
+}
 
-    std::map<int, int> valueCounts ={{64, 2513}, {14, 1256}}; //statistics from single user run 
-    size_t ampduSize = pickSuAmpduByProbability(valueCounts);   
-    
-    return ampduSize;
+Time
+RrsumuScheduler::GetSuAirtime (const CandidateInfo& candidate, uint16_t ampduLength,
+                               uint16_t guardInterval) const
+{
+  const WifiTxVector& txVector = m_stations.GetTxVector (candidate.first);
+  return m_costModel->GetSuAirtime (txVector.GetMode ().GetMcsValue (), txVector.GetNss (),
+                                    ampduLength, guardInterval);
+}
 
- 
-     
+void
+RrsumuScheduler::PrepareCostModel (void)
+{
+  NS_LOG_FUNCTION (this);
 
+  Ptr<WifiPhy> phy = m_apMac->GetWifiPhy ();
+  Ptr<HeConfiguration> heConfiguration = m_apMac->GetHeConfiguration ();
+  uint16_t maxAmpduLength = heConfiguration->GetMpduBufferSize ();
+  uint16_t gi = heConfiguration->GetGuardInterval ().GetNanoSeconds ();
+
+  if (!m_costModel->IsConfigured (phy->GetChannelWidth (), maxAmpduLength, gi))
+    {
+      NS_LOG_DEBUG ("Configuring the cost model for a " << phy->GetChannelWidth () << " MHz channel and "
+                    << gi << " ns guard interval");
+      // control frames are sent by using the TXVECTOR for non-HT control responses
+      m_costModel->Configure (phy, GetWifiRemoteStationManager ()->GetRtsTxVector (Mac48Address::GetBroadcast ()),
+                              maxAmpduLength, gi);
+    }
+}
+
+const RrsumuScheduler::MacOverheads&
+RrsumuScheduler::GetMacOverheads (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_edca != nullptr);
+
+  Ptr<WifiPhy> phy = m_apMac->GetWifiPhy ();
+  uint8_t aifsn = m_edca->GetAifsn ();
+  uint32_t cwMin = m_edca->GetMinCw ();
+
+  if (phy->GetSlot () != m_overheads.slot || phy->GetSifs () != m_overheads.sifs
+      || m_nominalPacketPadding != m_overheads.pe || aifsn != m_overheads.aifsn
+      || cwMin != m_overheads.cwMin)
+    {
+      m_overheads.slot = phy->GetSlot ();
+      m_overheads.sifs = phy->GetSifs ();
+      // the PE duration of HE SU and HE MU PPDUs equals the nominal packet
+      // padding when the last OFDM symbol is fully used (a-factor = 4)
+      m_overheads.pe = m_nominalPacketPadding;
+      m_overheads.aifsn = aifsn;
+      m_overheads.cwMin = cwMin;
+      m_overheads.aifs = m_overheads.sifs + m_overheads.slot * static_cast<int64_t> (aifsn);
+      // the backoff counter is drawn uniformly in [0, CWmin]
+      m_overheads.backoff = m_overheads.slot * static_cast<int64_t> (cwMin) / 2;
+      NS_LOG_DEBUG ("MAC overheads: AIFS=" << m_overheads.aifs.As (Time::US)
+                    << ", mean backoff=" << m_overheads.backoff.As (Time::US)
+                    << ", PE=" << m_overheads.pe.As (Time::US));
+    }
+  return m_overheads;
 }
 
 MultiUserScheduler::DlMuInfo
@@ -1074,10 +1748,11 @@ RrsumuScheduler::ComputeDlMuInfo (void)
   uint16_t bw = m_apMac->GetWifiPhy ()->GetChannelWidth ();
 
   // compute how many stations can be granted an RU and the RU size
-  std::size_t nRusAssigned = m_txParams.GetPsduInfoMap ().size ();
+  // (the candidates may have been restricted to a group smaller than the set
+  // of stations scanned by TrySendingDlMuPpdu)
+  std::size_t nRusAssigned = std::min (m_txParams.GetPsduInfoMap ().size (), m_candidates.size ());
   // std::size_t nRusAssigned = 1; 
   
-  std::cout<<"No. of RUs assigned for MU: "<< nRusAssigned <<std::endl; 
   
   std::size_t nCentral26TonesRus1;
   // std::size_t nCentral26TonesRus2;
@@ -1085,102 +1760,129 @@ RrsumuScheduler::ComputeDlMuInfo (void)
   HeRu::RuType ruType = HeRu::GetEqualSizedRusForStations (bw, nRusAssigned, nCentral26TonesRus1);
   // HeRu::RuType ruType2 = HeRu::GetEqualSizedRusForStations (bw, nRusAssigned2, nCentral26TonesRus2);
   NS_LOG_DEBUG (nRusAssigned << " stations are being assigned a " << ruType << " RU");
-  std::cout << nRusAssigned << " stations are being assigned a " << ruType << " RU" << std::endl;
-  // std::cout << nCentral26TonesRus1 << " stations are being assigned a " << "26-tones" << " RU" << std::endl;
 
-  // std::cout << 1 << " station is being assigned a " << ruType2 << " RU" << std::endl;
 
   if (!m_useCentral26TonesRus || m_candidates.size () == nRusAssigned)
     {
-      // std::cout<<"Inside if condition";
       nCentral26TonesRus1 = 0;
     }
   else
     {
       nCentral26TonesRus1 = std::min (m_candidates.size () - nRusAssigned, nCentral26TonesRus1);
       NS_LOG_DEBUG (nCentral26TonesRus1 << " stations are being assigned a 26-tones RU");
-      //std::cout << nCentral26TonesRus << " stations are being assigned a 26-tones RU" << std::endl;
     }
 
   // nCentral26TonesRus2 = 0; 
   
-  // std::cout<<"Before DlMUInfo";
   DlMuInfo dlMuInfo;
+  Ptr<const WifiMacQueueItem> mpdu;
 
-  // We have to update the TXVECTOR
-  dlMuInfo.txParams.m_txVector.SetPreambleType (m_txParams.m_txVector.GetPreambleType ());
-  dlMuInfo.txParams.m_txVector.SetChannelWidth (m_txParams.m_txVector.GetChannelWidth ());
-  dlMuInfo.txParams.m_txVector.SetGuardInterval (m_txParams.m_txVector.GetGuardInterval ());
-  dlMuInfo.txParams.m_txVector.SetBssColor (m_txParams.m_txVector.GetBssColor ());
+  // The TX parameters computed while scanning the candidates already include
+  // the final RUs if all the candidates are served and the RU type is unchanged
+  bool reuseScanTxParams = (m_ruAllocation == EQUAL_SIZE_RUS
+                            && nRusAssigned + nCentral26TonesRus1 == m_candidates.size ()
+                            && m_txParams.GetPsduInfoMap ().size () == m_candidates.size ());
 
-  
-  auto candidateIt = m_candidates.begin (); // iterator over the list of candidate receivers
-  // auto candidateIt2 = m_candidates2.begin (); // iterator over the list of candidate receivers for single user transmission
-  
+  // the ack manager determines the acknowledgment of the DL MU PPDU when the
+  // MPDUs are added to the TX parameters, hence its DL MU ack sequence type is
+  // only changed while the PSDUs of this DL MU PPDU are built and then restored
+  EnumValue ackSequenceType;
+  bool restoreAckSequenceType = false;
 
-  
-  for (std::size_t i = 0; i < nRusAssigned + nCentral26TonesRus1; i++)
+  if (m_adaptiveDlAckSequence && m_txParams.m_acknowledgment->method != m_muAckMethod)
     {
-      NS_ASSERT (candidateIt != m_candidates.end ());
+      NS_LOG_DEBUG ("Using DL MU ack method " << m_muAckMethod << " for this DL MU PPDU");
+      m_heFem->GetAckManager ()->GetAttribute ("DlMuAckSequenceType", ackSequenceType);
+      m_heFem->GetAckManager ()->SetAttribute ("DlMuAckSequenceType", EnumValue (m_muAckMethod));
+      restoreAckSequenceType = true;
+      reuseScanTxParams = false;
+    }
+  std::size_t index = 0;
 
-      uint16_t staId = candidateIt->first->aid;
-      // AssignRuIndices will be called below to set RuSpec
-      dlMuInfo.txParams.m_txVector.SetHeMuUserInfo (staId,
-                                                    {{(i < nRusAssigned ? ruType : HeRu::RU_26_TONE), 1, false},
-                                                      m_txParams.m_txVector.GetMode (staId),
-                                                      m_txParams.m_txVector.GetNss (staId)});
-      candidateIt++;
+  for (auto it = m_candidates.begin (); reuseScanTxParams && it != m_candidates.end (); it++, index++)
+    {
+      reuseScanTxParams = (m_txParams.m_txVector.GetRu (m_stations.GetAid (it->first)).GetRuType ()
+                           == (index < nRusAssigned ? ruType : HeRu::RU_26_TONE));
     }
 
-    
+  if (reuseScanTxParams)
+    {
+      NS_LOG_DEBUG ("Reusing the TX parameters computed while scanning the candidates");
+      dlMuInfo.txParams = std::move (m_txParams);
+    }
+  else
+    {
+      // We have to update the TXVECTOR
+      dlMuInfo.txParams.m_txVector.SetPreambleType (m_txParams.m_txVector.GetPreambleType ());
+      dlMuInfo.txParams.m_txVector.SetChannelWidth (m_txParams.m_txVector.GetChannelWidth ());
+      dlMuInfo.txParams.m_txVector.SetGuardInterval (m_txParams.m_txVector.GetGuardInterval ());
+      dlMuInfo.txParams.m_txVector.SetBssColor (m_txParams.m_txVector.GetBssColor ());
 
-    
+      if (m_ruAllocation == BACKLOG_WEIGHTED_RUS)
+        {
+          AssignWeightedRus (dlMuInfo.txParams.m_txVector);
+        }
+      else
+        {
+          auto candidateIt = m_candidates.begin (); // iterator over the list of candidate receivers
 
-  // for (std::size_t i = 0; i < 1; i++)
-  //   {
-  //     NS_ASSERT (candidateIt2 != m_candidates2.end ());
+          for (std::size_t i = 0; i < nRusAssigned + nCentral26TonesRus1; i++)
+            {
+              NS_ASSERT (candidateIt != m_candidates.end ());
 
-  //     uint16_t staId = candidateIt2->first->aid;
-  //     // AssignRuIndices will be called below to set RuSpec
-  //     dlMuInfo2.txParams.m_txVector.SetHeMuUserInfo (staId,
-  //                                                   {{(HeRu::RU_484_TONE), 1, false},
-  //                                                     m_txParams2.m_txVector.GetMode (staId),
-  //                                                     m_txParams2.m_txVector.GetNss (staId)});
-  //     candidateIt2++;
-  //   }
-  // remove candidates that will not be served
-  m_candidates.erase (candidateIt, m_candidates.end ());
+              uint16_t staId = m_stations.GetAid (candidateIt->first);
+              // AssignRuIndices will be called below to set RuSpec
+              dlMuInfo.txParams.m_txVector.SetHeMuUserInfo (staId,
+                                                            {{(i < nRusAssigned ? ruType : HeRu::RU_26_TONE), 1, false},
+                                                              m_txParams.m_txVector.GetMode (staId),
+                                                              m_txParams.m_txVector.GetNss (staId)});
+              candidateIt++;
+            }
 
-  
-  // m_candidates2.erase (candidateIt2, m_candidates2.end ());
-  
-  std::cout<<"In ComputeDlMuInfo \n Length of m_candidates: "<<m_candidates.size()<<std::endl; 
-  // std::cout<<"In ComputeDlMuInfo \n Length of m_candidates: "<<m_candidates.size()<<"Length of m_candidates2: "<<m_candidates2.size()<<std::endl; 
+          // remove candidates that will not be served
+          m_candidates.erase (candidateIt, m_candidates.end ());
 
-  AssignRuIndices (dlMuInfo.txParams.m_txVector);
+          AssignRuIndices (dlMuInfo.txParams.m_txVector);
+        }
 
-  m_txParams.Clear();
-  
-  Ptr<const WifiMacQueueItem> mpdu;
+      NS_LOG_DEBUG ("Number of candidates: " << m_candidates.size ());
 
-  // Compute the TX params (again) by using the stored MPDUs and the final TXVECTOR
-  Time actualAvailableTime = (m_initialFrame ? Time::Min () : m_availableTime);
-  
+      // Compute the TX params (again) by using the stored MPDUs and the final TXVECTOR
+      Time actualAvailableTime = (m_initialFrame ? Time::Min () : m_availableTime);
 
-  // std::cout<<"MU TXOP started? : "<< m_initialFrame<<std::endl;  
-  for (const auto& candidate : m_candidates)
-    {
-      mpdu = candidate.second;
-      NS_ASSERT (mpdu != nullptr);
-      
-      // std::cout<<"The available time for MU Transmission is "<<actualAvailableTime<<std::endl; 
-      bool ret = m_heFem->TryAddMpdu (mpdu, dlMuInfo.txParams, actualAvailableTime);
-      NS_UNUSED (ret);
-      NS_ASSERT_MSG (ret, "Weird that an MPDU does not meet constraints when "
-                          "transmitted over a larger RU");
+      for (auto candidateIt = m_candidates.begin (); candidateIt != m_candidates.end (); )
+        {
+          mpdu = candidateIt->second;
+          NS_ASSERT (mpdu != nullptr);
+
+          if (m_heFem->TryAddMpdu (mpdu, dlMuInfo.txParams, actualAvailableTime))
+            {
+              candidateIt++;
+              continue;
+            }
+          // a weighted RU may be smaller than the RU used while scanning the
+          // candidates and the ack sequence may have changed, hence the
+          // candidate is removed from the group
+          NS_LOG_DEBUG ("The MPDU for STA " << m_stations.GetAid (candidateIt->first)
+                        << " does not meet the time constraints over the allocated RU");
+          dlMuInfo.txParams.m_txVector.GetHeMuUserInfoMap ().erase (m_stations.GetAid (candidateIt->first));
+          candidateIt = m_candidates.erase (candidateIt);
+        }
+
+      if (m_candidates.empty ())
+        {
+          NS_LOG_DEBUG ("No candidate station meets the time constraints");
+          m_txParams.Clear ();
+          if (restoreAckSequenceType)
+            {
+              m_heFem->GetAckManager ()->SetAttribute ("DlMuAckSequenceType", ackSequenceType);
+            }
+          return DlMuInfo ();
+        }
     }
 
-    
+  m_txParams.Clear();
+
   // We have to complete the PSDUs to send
   // Ptr<WifiMacQueue> queue;
   Mac48Address receiver;
@@ -1198,18 +1900,15 @@ RrsumuScheduler::ComputeDlMuInfo (void)
 
   // file << "======= SCHEDULER BEGINS AGGREGATION ========\n";
   // uint8_t candidateIterator=0; 
-  // std::cout<<"Total Packets before MU aggregation "<<que->GetNPackets()<<std::endl;
-  int iterator=0; 
 
   for (const auto& candidate : m_candidates)
     {
       // Let us try first A-MSDU aggregation if possible
       mpdu = candidate.second;
-      // std::cout<<"MU: This is the MPDU: " << mpdu <<std::endl; 
       NS_ASSERT (mpdu != nullptr);
       uint8_t tid = mpdu->GetHeader ().GetQosTid ();
       receiver = mpdu->GetHeader ().GetAddr1 ();
-      NS_ASSERT (receiver == candidate.first->address);
+      NS_ASSERT (receiver == m_stations.GetAddress (candidate.first));
       
       NS_ASSERT (mpdu->IsQueued ());
       WifiMacQueueItem::QueueIteratorPair queueIt = mpdu->GetQueueIteratorPairs ().front ();
@@ -1243,89 +1942,84 @@ RrsumuScheduler::ComputeDlMuInfo (void)
           // m_apMac->GetQosTxop (QosUtilsMapTidToAc (tid))->AssignSequenceNumber (item2);
         }
 
-      // std::cout<<"MU Item value: "<< item<<std::endl;  
       // Now, let's try A-MPDU aggregation if possible
       std::vector<Ptr<WifiMacQueueItem>> mpduList = m_heFem->GetMpduAggregator ()->GetNextAmpdu (item, dlMuInfo.txParams, m_availableTime, queueIt);
       
       
-      // if ( mpduList.size() > 0 )
-      //   std::cout << "STA_" << candidate.first->aid << " is being sent an A-MPDU of size " << mpduList.size() << " after aggregation" << std::endl;
       if (mpduList.size () > 1)
         {
-          //file << "STA_" << candidate.first->aid << " assigned a PSDU of size " << mpduList.size() << " after aggregation\n";
+          //file << "STA_" << m_stations.GetAid (candidate.first) << " assigned a PSDU of size " << mpduList.size() << " after aggregation\n";
            
           // A-MPDU aggregation succeeded, update psduMap
-          dlMuInfo.psduMap[candidate.first->aid] = Create<WifiPsdu> (std::move (mpduList));
+          dlMuInfo.psduMap[m_stations.GetAid (candidate.first)] = Create<WifiPsdu> (std::move (mpduList));
           
         }
 
         else
         {
 
-          //file << "STA_" << candidate.first->aid << " assigned a PSDU of size " << mpduList.size() << " without aggregation\n";
+          //file << "STA_" << m_stations.GetAid (candidate.first) << " assigned a PSDU of size " << mpduList.size() << " without aggregation\n";
 
-          dlMuInfo.psduMap[candidate.first->aid] = Create<WifiPsdu> (item, true);
+          dlMuInfo.psduMap[m_stations.GetAid (candidate.first)] = Create<WifiPsdu> (item, true);
         
         }
        
        
-       size_t ampduSize = dlMuInfo.psduMap[candidate.first->aid]->GetNMpdus();
+       size_t ampduSize = dlMuInfo.psduMap[m_stations.GetAid (candidate.first)]->GetNMpdus();
        
-       std::cout << "For MU -- STA_" << candidate.first->aid << " is being sent an A-MPDU of size " << ampduSize << " after aggregation" << std::endl;
-       
-       mu_ampdu[iterator++]=ampduSize; 
+       NS_LOG_DEBUG ("STA_" << m_stations.GetAid (candidate.first) << " is being sent an A-MPDU of size " << ampduSize);
       
     }
 
-      std::cout<<"Total Packets after MU aggregation "<<que->GetNPackets()<<std::endl;
 
 //Inference: Queue size remains same before and after aggregation 
+
+  if (restoreAckSequenceType)
+    {
+      // the acknowledgment of this DL MU PPDU is stored in its TX parameters
+      m_heFem->GetAckManager ()->SetAttribute ("DlMuAckSequenceType", ackSequenceType);
+    }
  
   // file << "======= SCHEDULER ENDS AGGREGATION ========\n";
   // file.close();
 
+  for (const auto& candidate : m_candidates)
+    {
+      Ptr<const WifiPsdu> psdu = dlMuInfo.psduMap[m_stations.GetAid (candidate.first)];
+      m_muAmpduHistory->NotifyPsdu (m_stations.GetAddress (candidate.first), psdu->GetNMpdus (),
+                                    psdu->GetSize (), dlMuInfo.txParams.m_txDuration);
+    }
+
   AcIndex primaryAc = m_edca->GetAccessCategory ();
 
   // The amount of credits received by each station equals the TX duration (in
   // microseconds) divided by the number of stations.
+  CreditHeap& credits = m_stations.GetCredits (primaryAc);
   double creditsPerSta = dlMuInfo.txParams.m_txDuration.ToDouble (Time::US)
-                        / m_staList[primaryAc].size ();
+                        / credits.GetSize ();
   // Transmitting stations have to pay a number of credits equal to the TX duration
   // (in microseconds) times the allocated bandwidth share.
-  double debitsPerMhz = dlMuInfo.txParams.m_txDuration.ToDouble (Time::US)
-                        / (nRusAssigned * HeRu::GetBandwidth (ruType)
-                          + nCentral26TonesRus1 * HeRu::GetBandwidth (HeRu::RU_26_TONE));
-
-  
-  // assign credits to all stations
-  for (auto& sta : m_staList[primaryAc])
+  uint16_t allocatedBw = 0;
+  for (const auto& candidate : m_candidates)
     {
-      sta.credits += creditsPerSta;
-      sta.credits = std::min (sta.credits, m_maxCredits.ToDouble (Time::US));
+      allocatedBw += HeRu::GetBandwidth (dlMuInfo.txParams.m_txVector.GetRu (m_stations.GetAid (candidate.first)).GetRuType ());
     }
+  double debitsPerMhz = dlMuInfo.txParams.m_txDuration.ToDouble (Time::US) / allocatedBw;
 
-  // subtract debits to the selected stations
-  candidateIt = m_candidates.begin ();
+  // assign credits to all stations
+  credits.AddToAll (creditsPerSta);
+  credits.ClampAbove (m_maxCredits.ToDouble (Time::US));
 
-  for (std::size_t i = 0; i < nRusAssigned + nCentral26TonesRus1; i++)
+  // subtract debits to the selected stations
+  for (const auto& candidate : m_candidates)
     {
-      NS_ASSERT (candidateIt != m_candidates.end ());
-
-      candidateIt->first->credits -= debitsPerMhz * HeRu::GetBandwidth (i < nRusAssigned ? ruType : HeRu::RU_26_TONE);
-
-      candidateIt++;
+      HeRu::RuType staRuType = dlMuInfo.txParams.m_txVector.GetRu (m_stations.GetAid (candidate.first)).GetRuType ();
+      credits.Add (candidate.first, -debitsPerMhz * HeRu::GetBandwidth (staRuType));
     }
 
-  
-
-  // sort the list in decreasing order of credits
-  m_staList[primaryAc].sort ([] (const MasterInfo& a, const MasterInfo& b)
-                              { return a.credits > b.credits; });
 
-  NS_LOG_DEBUG ("Next station to serve has AID=" << m_staList[primaryAc].front ().aid);
+  NS_LOG_DEBUG ("Next station to serve has AID=" << m_stations.GetAid (credits.Top ()));
   
-  // int result = calculate_su_mpdu();
-  // std::cout<<"Result here: "<<result; 
 
   return dlMuInfo;
 }
@@ -1335,47 +2029,82 @@ RrsumuScheduler::AssignRuIndices (WifiTxVector& txVector)
 {
   NS_LOG_FUNCTION (this << txVector);
 
-  uint8_t bw = txVector.GetChannelWidth ();
+  uint16_t bw = txVector.GetChannelWidth ();
 
-  // find the RU types allocated in the TXVECTOR
-  std::set<HeRu::RuType> ruTypeSet;
+  // This scheduler allocates equal sized RUs and optionally the remaining 26-tone
+  // RUs, hence find the RU type that is not 26-tone, if any
+  HeRu::RuType ruType = HeRu::RU_26_TONE;
   for (const auto& userInfo : txVector.GetHeMuUserInfoMap ())
     {
-      ruTypeSet.insert (userInfo.second.ru.GetRuType ());
+      if (userInfo.second.ru.GetRuType () != HeRu::RU_26_TONE)
+        {
+          NS_ASSERT (ruType == HeRu::RU_26_TONE || ruType == userInfo.second.ru.GetRuType ());
+          ruType = userInfo.second.ru.GetRuType ();
+        }
     }
 
-  std::vector<HeRu::RuSpec> ruSet, central26TonesRus;
+  // RUs are taken from the RU layout table, hence no memory is allocated
+  std::size_t ruPos = 0;
+  std::size_t central26TonesRuPos = 0;
 
-  // This scheduler allocates equal sized RUs and optionally the remaining 26-tone RUs
-  if (ruTypeSet.size () == 2)
+  for (const auto& userInfo : txVector.GetHeMuUserInfoMap ())
     {
-      // central 26-tone RUs have been allocated
-      NS_ASSERT (ruTypeSet.find (HeRu::RU_26_TONE) != ruTypeSet.end ());
-      ruTypeSet.erase (HeRu::RU_26_TONE);
-      NS_ASSERT (ruTypeSet.size () == 1);
-      central26TonesRus = HeRu::GetCentral26TonesRus (bw, *ruTypeSet.begin ());
+      if (userInfo.second.ru.GetRuType () == ruType)
+        {
+          txVector.SetRu (RuLayout::GetRu (bw, ruType, ruPos++), userInfo.first);
+        }
+      else
+        {
+          // central 26-tone RUs have been allocated
+          txVector.SetRu (RuLayout::GetCentral26TonesRu (bw, ruType, central26TonesRuPos++),
+                          userInfo.first);
+        }
     }
+}
+
+void
+RrsumuScheduler::AssignWeightedRus (WifiTxVector& txVector)
+{
+  NS_LOG_FUNCTION (this << txVector);
 
-  NS_ASSERT (ruTypeSet.size () == 1);
-  ruSet = HeRu::GetRusOfType (bw, *ruTypeSet.begin ());
+  uint16_t bw = txVector.GetChannelWidth ();
+  uint16_t gi = txVector.GetGuardInterval ();
 
-  auto ruSetIt = ruSet.begin ();
-  auto central26TonesRusIt = central26TonesRus.begin ();
+  // the weight of a station is the time needed to transmit the bytes queued
+  // for the station over the whole channel, which is proportional to the
+  // number of tones needed to transmit them in a given time
+  std::vector<double> weights;
+  weights.reserve (m_candidates.size ());
 
-  for (const auto& userInfo : txVector.GetHeMuUserInfoMap ())
+  for (const auto& candidate : m_candidates)
     {
-      if (userInfo.second.ru.GetRuType () == *ruTypeSet.begin ())
-        {
-          NS_ASSERT (ruSetIt != ruSet.end ());
-          txVector.SetRu (*ruSetIt, userInfo.first);
-          ruSetIt++;
-        }
-      else
+      uint16_t staId = m_stations.GetAid (candidate.first);
+      uint8_t tid = candidate.second->GetHeader ().GetQosTid ();
+      uint32_t bytes = std::max (m_backlogIndex->GetBacklog (m_stations.GetAddress (candidate.first), tid).bytes,
+                                 candidate.second->GetSize ());
+      uint64_t rate = m_txParams.m_txVector.GetMode (staId).GetDataRate (bw, gi, m_txParams.m_txVector.GetNss (staId));
+      weights.push_back (8.0 * bytes / rate);
+    }
+
+  std::map<std::size_t, HeRu::RuSpec> allocation = WeightedRuAllocator (bw).Allocate (weights);
+
+  std::size_t index = 0;
+  for (auto candidateIt = m_candidates.begin (); candidateIt != m_candidates.end (); index++)
+    {
+      auto ruIt = allocation.find (index);
+      if (ruIt == allocation.end ())
         {
-          NS_ASSERT (central26TonesRusIt != central26TonesRus.end ());
-          txVector.SetRu (*central26TonesRusIt, userInfo.first);
-          central26TonesRusIt++;
+          NS_LOG_DEBUG ("No RU allocated to STA " << m_stations.GetAid (candidateIt->first));
+          candidateIt = m_candidates.erase (candidateIt);
+          continue;
         }
+
+      uint16_t staId = m_stations.GetAid (candidateIt->first);
+      NS_LOG_DEBUG ("STA " << staId << " (weight=" << weights[index] << ") allocated RU " << ruIt->second);
+      txVector.SetHeMuUserInfo (staId, {ruIt->second,
+                                        m_txParams.m_txVector.GetMode (staId),
+                                        m_txParams.m_txVector.GetNss (staId)});
+      candidateIt++;
     }
 }
 
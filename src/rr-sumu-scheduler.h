@@ -22,10 +22,26 @@
 #define RR_MULTI_USER_SCHEDULER_H
 
 #include "multi-user-scheduler.h"
+#include "sumu-cost-model.h"
+#include "tx-duration-cache.h"
+#include "ampdu-size-distribution.h"
+#include "ampdu-history.h"
+#include "backlog-index.h"
+#include "buffer-status-tracker.h"
+#include "station-table.h"
+#include "sumu-decision-trace.h"
+#include "weighted-ru-allocator.h"
+#include "ru-layout.h"
+#include "mu-group-scorer.h"
+#include "txop-planner.h"
+#include "su-mu-selection-policy.h"
+#include "ns3/traced-callback.h"
+#include "ns3/originator-block-ack-agreement.h"
+#include "wifi-phy.h"
+#include <deque>
 #include <list>
 #include <map>
 #include <vector>
-#include <random>
 
 namespace ns3 {
 
@@ -52,6 +68,24 @@ public:
   static TypeId GetTypeId (void);
   RrsumuScheduler ();
   virtual ~RrsumuScheduler ();
+
+  /**
+   * How RUs are allocated to the stations served by a DL MU PPDU
+   */
+  enum RuAllocation
+  {
+    EQUAL_SIZE_RUS = 0,     //!< RUs of the same size (and possibly central 26-tone RUs)
+    BACKLOG_WEIGHTED_RUS    //!< RUs sized by the queued bytes and MCS of the stations
+  };
+
+  /**
+   * How the length of the A-MPDU sent to the SU candidate is estimated
+   */
+  enum SuAmpduEstimation
+  {
+    QUEUE_WALK = 0,         //!< walk the queue of the candidate (exact, linear in the A-MPDU length)
+    LEARNED_DISTRIBUTION    //!< draw from the lengths of the SU A-MPDUs sent to the candidate (constant time)
+  };
    void setMacaddresses(std::vector<Mac48Address> macaddresses );
    
    void setAPqueue(Ptr<WifiMacQueue> que);
@@ -59,19 +93,256 @@ public:
    
    Ptr<WifiMacQueue> getAPqueue( );
 
+  /**
+   * Get the cache of TX durations used by this scheduler, e.g., to read
+   * its hit and miss counters.
+   *
+   * \return the TX duration cache
+   */
+  Ptr<TxDurationCache> GetTxDurationCache (void) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this scheduler. Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this scheduler
+   */
+  int64_t AssignStreams (int64_t stream);
+
 protected:
   void DoDispose (void) override;
   void DoInitialize (void) override;
 
 private:
+  /**
+   * Information stored for candidate stations: the slot of the station in the
+   * station table and the MPDU peeked for the station
+   */
+  typedef std::pair<std::size_t, Ptr<const WifiMacQueueItem>> CandidateInfo;
+
+  /**
+   * An SU PPDU planned to be sent later in the TXOP
+   */
+  struct PlannedSuPpdu
+  {
+    std::size_t slot;     //!< the slot of the receiver in the station table
+    uint8_t tid;          //!< the TID of the frames carried by the PPDU
+    Time airtime;         //!< the predicted airtime of the SU frame exchange
+  };
+
   TxFormat SelectTxFormat (void) override;
   DlMuInfo ComputeDlMuInfo (void) override;
   UlMuInfo ComputeUlMuInfo (void) override;
 
-  virtual int calculate_su_mpdu (void); //Checks if there are candidates available for SU Transmission
+  /**
+   * Estimate the number of MPDUs in the A-MPDU that would be sent to the SU
+   * candidate station, either by walking its queue or by drawing from the
+   * distribution learned for it, depending on m_suAmpduEstimation. The
+   * estimate is also stored in m_suEstimate.
+   *
+   * \param responseTime the duration of the response to the SU PPDU
+   * \return the number of MPDUs in the A-MPDU (0 if there is no SU candidate)
+   */
+  virtual int calculate_su_mpdu (Time responseTime);
+
+  /**
+   * Check whether the last SU/MU decision can be reused, i.e., its predicted
+   * margin is outside the hysteresis band and neither the candidate stations
+   * nor the number of queued packets changed materially.
+   *
+   * \param candidateAids the sorted AIDs of the current candidate stations
+   * \param nQueuedPackets the number of packets queued by the AC that gained access
+   * \return true if the last decision can be reused
+   */
+  bool CanReuseLastDecision (const std::vector<uint16_t>& candidateAids,
+                             uint32_t nQueuedPackets) const;
+
+  /// Outcome of a dry-run SU A-MPDU aggregation
+  struct SuAmpduEstimate
+  {
+    uint16_t nMpdus;      //!< number of MPDUs in the A-MPDU
+    uint32_t nBytes;      //!< sum of the sizes of the MPDUs
+    uint32_t ampduSize;   //!< size of the A-MPDU, including delimiters and padding
+    Time duration;        //!< TX duration of the SU PPDU (zero if not computed)
+  };
+
+  /**
+   * Walk the queue of the receiver and TID of the given MPDU, starting from
+   * the given MPDU, and determine the A-MPDU that would be sent in an SU PPDU.
+   * Neither the queue nor the sequence numbers are modified. The A-MPDU is
+   * limited by the transmit window of the BA agreement, the maximum A-MPDU size,
+   * the maximum PPDU duration and the given available time.
+   *
+   * \param mpdu the (queued) MPDU peeked for the receiver
+   * \param txVector the TX vector of the SU PPDU
+   * \param availableTime the time available for the frame exchange (Time::Min ()
+   *        if there is no time limit)
+   * \param responseTime the duration of the response to the SU PPDU
+   * \return the estimated A-MPDU
+   */
+  SuAmpduEstimate EstimateSuAmpdu (Ptr<const WifiMacQueueItem> mpdu, const WifiTxVector& txVector,
+                                   Time availableTime, Time responseTime);
+
+  /**
+   * Fire the SuMuDecision trace source, if any sink is connected to it.
+   *
+   * \param format the selected TX format
+   * \param nQueuedPackets the number of packets queued by the AC that gained access
+   * \param suDuration the predicted duration of the SU frame exchange
+   * \param muDuration the predicted duration of the DL MU frame exchange
+   * \param muGroupSize the number of candidate stations the DL MU PPDU is sent to
+   * \param reused whether the last decision has been reused
+   */
+  void TraceDecision (TxFormat format, uint32_t nQueuedPackets, Time suDuration,
+                      Time muDuration, std::size_t muGroupSize, bool reused);
+
+  /**
+   * Plan the sequence of PPDUs to send in the TXOP being started, so that the
+   * number of bytes delivered in the TXOP is maximized. The first PPDU is
+   * either the SU PPDU to the first candidate or a DL MU PPDU to a group of
+   * candidates scored by m_groupScorer; the following SU PPDUs are stored in
+   * m_txopPlan along with the TID they have been planned for. SU PPDUs to
+   * candidates whose peeked frame belongs to an AC other than the one that
+   * gained access are not planned, because only the frames of such AC can be
+   * sent in the TXOP.
+   *
+   * \param suAirtime the airtime of the SU frame exchange with the first candidate
+   * \param guardInterval the guard interval in nanoseconds
+   */
+  void PlanTxop (Time suAirtime, uint16_t guardInterval);
+
+  /**
+   * Prepare the SU PPDU to the next station in the TXOP plan that the AP
+   * still has frames of the planned TID for, if any. The rest of the plan is
+   * dropped if the predicted airtime of the PPDU exceeds the remaining TXOP.
+   *
+   * \return SU_TX if an SU PPDU has been prepared, NO_TX otherwise
+   */
+  TxFormat TrySendingPlannedSuPpdu (void);
+
+  /**
+   * Called when an SU PPDU has been selected. The FEM builds the SU PSDU
+   * starting from the frame at the head of the queue of the AC that gained
+   * access, hence the frame peeked for the selected receiver is moved to the
+   * head of its queue and the receiver is charged credits for the airtime.
+   * Nothing is moved and the TXOP plan is dropped if a BlockAckReq or a frame
+   * to retransmit to another station would be sent first.
+   */
+  void EnforceSuReceiver (void);
+
+  /**
+   * Predict the length of the A-MPDU an SU PPDU to the given candidate would
+   * carry from the frames queued for the candidate and the TID of its peeked
+   * frame, limited by the maximum A-MPDU length and the BA transmit window.
+   * Unlike EstimateSuAmpdu, the queue is not walked.
+   *
+   * \param candidate the candidate station
+   * \return the predicted number of MPDUs in the A-MPDU
+   */
+  uint16_t GetBacklogAmpduLength (const CandidateInfo& candidate) const;
+
+  /**
+   * Get the airtime of the SU frame exchange in which the given candidate is
+   * sent an A-MPDU of the given length, by using the MCS and the number of
+   * spatial streams of the SU TX vector of the candidate. This is the only
+   * source of the SU airtime of the candidates, be it compared against the DL
+   * MU alternative, logged or used to plan the TXOP.
+   *
+   * \param candidate the candidate station
+   * \param ampduLength the number of MPDUs in the A-MPDU
+   * \param guardInterval the guard interval in nanoseconds
+   * \return the duration of the SU PPDU plus the BlockAck
+   */
+  Time GetSuAirtime (const CandidateInfo& candidate, uint16_t ampduLength, uint16_t guardInterval) const;
+
+  /**
+   * Make sure that the cost model has been configured for the current channel
+   * width, guard interval and maximum A-MPDU length, (re)configuring it if needed.
+   */
+  void PrepareCostModel (void);
+
+  /// MAC overheads of a frame exchange, derived from the PHY and EDCA parameters
+  struct MacOverheads
+  {
+    Time slot;                 //!< slot duration
+    Time sifs;                 //!< SIFS
+    Time pe;                   //!< packet extension
+    Time aifs;                 //!< AIFS of the AC that gained channel access
+    Time backoff;              //!< mean backoff of the AC that gained channel access
+    uint8_t aifsn {0};         //!< AIFSN the overheads refer to
+    uint32_t cwMin {0};        //!< CWmin the overheads refer to
+  };
+
+  /**
+   * Get the MAC overheads for the AC that gained channel access, recomputing
+   * them if the PHY or the EDCA parameters changed since the last call.
+   *
+   * \return the MAC overheads
+   */
+  const MacOverheads& GetMacOverheads (void);
   // virtual int calculate_mu_mpdu (void); 
-  
-  virtual int pickSuAmpduByProbability(const std::map<int, int>& valueCounts);
+
+  /**
+   * Notify the scheduler that a PSDU has been forwarded down to the PHY, so
+   * that the length of the SU A-MPDUs sent to every station can be learned.
+   * Only connected if the SU A-MPDU length is drawn from the learned distribution.
+   *
+   * \param psdu the PSDU
+   * \param txVector the TX vector used to transmit the PSDU
+   */
+  void NotifyPsduForwardedDown (Ptr<const WifiPsdu> psdu, WifiTxVector txVector);
+
+  /**
+   * Notify the scheduler that the PHY of the AP received an MPDU, so that the
+   * UL data and the buffer status reports of the stations can be tracked.
+   *
+   * \param packet the received MPDU (including the MAC header)
+   * \param channelFreqMhz the frequency of the channel
+   * \param txVector the TX vector of the PPDU
+   * \param aMpdu the A-MPDU information
+   * \param signalNoise the signal and noise power
+   * \param staId the STA-ID of the PSDU
+   */
+  void NotifyMpduReceived (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                           MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId);
+
+  /**
+   * Read the queue size stored by the AP MAC for the given station after
+   * receiving a QoS Data or QoS Null frame carrying a Queue Size subfield
+   * from it and pass it to the buffer status tracker.
+   *
+   * \param address the MAC address of the station
+   */
+  void UpdateBufferStatus (Mac48Address address);
+
+  /**
+   * \return true if the buffer status reported by any of the candidate
+   *         stations is stale or missing
+   */
+  bool IsBufferStatusStale (void) const;
+
+  /**
+   * Notify the scheduler that a station having no eligible TIDs (see
+   * BacklogIndex::IsEligible) got one, or vice versa, so that the credit
+   * heaps only yield the stations that can be served in a DL MU PPDU.
+   *
+   * \param address the MAC address of the station
+   * \param eligible whether at least one TID of the station is eligible
+   */
+  void NotifyEligibilityState (Mac48Address address, bool eligible);
+  /**
+   * Notify the scheduler that the state of a Block Ack agreement established
+   * by the AP changed, so that the backlog index can be updated.
+   *
+   * \param now the time of the change
+   * \param recipient the recipient of the Block Ack agreement
+   * \param tid the TID of the Block Ack agreement
+   * \param state the new state of the Block Ack agreement
+   */
+  void NotifyAgreementState (Time now, Mac48Address recipient, uint8_t tid,
+                             OriginatorBlockAckAgreement::State state);
   /**
    * Check if it is possible to send a BSRP Trigger Frame given the current
    * time limits.
@@ -91,6 +362,25 @@ private:
 
   
 
+  /**
+   * Compare the UL MU frame exchange solicited by a Basic Trigger Frame with
+   * the UL SU frame exchange in which the station with the largest buffer
+   * contends for the channel and sends an HE SU PPDU occupying the whole
+   * channel. m_txParams must hold the TX parameters of the Trigger Frame.
+   * The UL SU frame exchange is preceded by the AIFS and the mean backoff of
+   * the stations (see the StaAifsn and StaCwMin attributes). Not soliciting
+   * the stations is assumed to leave the channel to such UL SU transmission,
+   * which only holds if the stations are allowed to contend for the channel.
+   *
+   * \param txVector the TXVECTOR of the TB PPDUs, including the UL MCS of the stations
+   * \param bufferSizes the bytes buffered by the solicited stations, indexed by AID
+   * \param tbPpduDuration the duration of the TB PPDUs
+   * \return true if the throughput predicted for UL MU is not lower than
+   *         the throughput predicted for UL SU
+   */
+  bool IsUlOfdmaBetter (const WifiTxVector& txVector, const std::map<uint16_t, uint32_t>& bufferSizes,
+                        Time tbPpduDuration);
+
   /**
    * Check if it is possible to send a DL MU PPDU given the current
    * time limits.
@@ -111,6 +401,17 @@ private:
    */
   void AssignRuIndices (WifiTxVector& txVector);
 
+  /**
+   * Allocate RUs of possibly different sizes to the candidate stations, so that
+   * the number of tones allocated to a station is roughly proportional to the
+   * time needed to transmit the bytes queued for the station and its TID at
+   * the MCS of the station. Candidate stations that are not allocated an RU
+   * are removed from the list of candidates.
+   *
+   * \param txVector the TXVECTOR of the DL MU PPDU, whose HE MU user info is set
+   */
+  void AssignWeightedRus (WifiTxVector& txVector);
+
   /**
    * Notify the scheduler that a station associated with the AP
    *
@@ -126,29 +427,22 @@ private:
    */
   void NotifyStationDeassociated (uint16_t aid, Mac48Address address);
 
-  /**
-   * Information used to sort stations
-   */
-  struct MasterInfo
-  {
-    uint16_t aid;                 //!< station's AID
-    Mac48Address address;         //!< station's MAC Address
-    double credits;               //!< credits accumulated by the station
-  };
-
-  /**
-   * Information stored for candidate stations
-   */
-  typedef std::pair<std::list<MasterInfo>::iterator, Ptr<const WifiMacQueueItem>> CandidateInfo;
-
   uint8_t m_nStations;                                  //!< Number of stations/slots to fill
   bool m_enableTxopSharing;                             //!< allow A-MPDUs of different TIDs in a DL MU PPDU
   bool m_forceDlOfdma;                                  //!< return DL_OFDMA even if no DL MU PPDU was built
   bool m_enableUlOfdma;                                 //!< enable the scheduler to also return UL_OFDMA
   bool m_enableBsrp;                                    //!< send a BSRP before an UL MU transmission
+  bool m_enableUlSuMuSelection;                         //!< compare UL MU with UL SU before sending a Basic TF
+  uint8_t m_staAifsn;                                   //!< AIFSN used by the stations for UL SU transmissions
+  uint32_t m_staCwMin;                                  //!< CWmin used by the stations for UL SU transmissions
+  bool m_adaptiveDlAckSequence;                         //!< select the ack sequence of every DL MU PPDU
+  WifiAcknowledgment::Method m_muAckMethod;             //!< ack sequence selected for the next DL MU PPDU
   bool m_useCentral26TonesRus;                          //!< whether to allocate central 26-tone RUs
+  RuAllocation m_ruAllocation;                          //!< how RUs are allocated in DL MU PPDUs
+  SuAmpduEstimation m_suAmpduEstimation;                //!< how the SU A-MPDU length is estimated
+  Ptr<SuMuSelectionPolicy> m_selectionPolicy;           //!< selects between SU and DL MU transmissions
   uint32_t m_ulPsduSize;                                //!< the size in byte of the solicited PSDU
-  std::map<AcIndex, std::list<MasterInfo>> m_staList;   //!< Per-AC list of stations (next to serve first)
+  StationTable m_stations;                              //!< stations associated with the AP
   std::list<CandidateInfo> m_candidates;                //!< Candidate stations for MU TX
   
   Time m_maxCredits;                                    //!< Max amount of credits a station can have
@@ -159,28 +453,52 @@ private:
   uint32_t num_stations;                                //!< stations in the environment
   // std::vector<Mac48Address> macaddresses;               //!< MAC addresses of stations in the environment
   Ptr<WifiMacQueue> que ;                               //!< pointer to AP queue
-  double threshold;                                     //!< threshold to decide SU tx or MU tx
+  double threshold;                                     //!< hysteresis band (Mbps) of the SU/MU decision
+  bool m_enableHysteresis;                              //!< whether the last decision can be reused
+  double m_hysteresisQueueChange;                       //!< relative queue change invalidating the last decision
+
+  /// Information about the last SU/MU decision
+  struct SuMuDecision
+  {
+    TxFormat format {NO_TX};                            //!< the selected format
+    double margin {0.0};                                //!< difference between the predicted throughputs (Mbps)
+    std::vector<uint16_t> candidates;                   //!< sorted AIDs of the candidate stations
+    uint32_t nQueuedPackets {0};                        //!< packets queued by the AC
+    std::size_t muGroupSize {0};                        //!< number of candidates served by DL MU
+    WifiAcknowledgment::Method muAckMethod {WifiAcknowledgment::DL_MU_BAR_BA_SEQUENCE}; //!< ack sequence of the DL MU group
+    Time suAirtime;                                     //!< predicted airtime of the SU frame exchange
+    Time muAirtime;                                     //!< predicted airtime of the DL MU frame exchange
+    double suThroughput {0.0};                          //!< predicted SU throughput (Mbps)
+    double muThroughput {0.0};                          //!< predicted DL MU throughput (Mbps)
+  };
+  SuMuDecision m_lastDecision;                          //!< the last SU/MU decision
+  TracedCallback<const SuMuDecisionRecord&> m_decisionTrace; //!< SU/MU decisions
+  TracedCallback<const SuMuSnapshot&, TxFormat> m_snapshotTrace; //!< inputs of the SU/MU selections
   
-  uint32_t slot_time = 9; 
-  uint32_t sifs = 16; 
-  uint32_t aifs = sifs+3*slot_time;                      //best effort time 
   uint32_t mpdu_size ; 
-  double bo = (15/2)*slot_time;
+  Time m_nominalPacketPadding;                          //!< nominal packet padding of the stations
+  MacOverheads m_overheads;                             //!< cached MAC overheads
+  Ptr<SuMuCostModel> m_costModel;                       //!< airtime of SU and MU frame exchanges
+  Ptr<TxDurationCache> m_durationCache;                 //!< memoized TX durations
+  Ptr<AmpduSizeDistribution> m_suAmpduDistribution;     //!< learned SU A-MPDU lengths
+  Ptr<BacklogIndex> m_backlogIndex;                     //!< per-(station, TID) backlog
+  Ptr<BufferStatusTracker> m_bufferStatus;              //!< UL buffer status of the stations
+  Ptr<AmpduHistory> m_muAmpduHistory;                   //!< recent DL MU PSDUs of the stations
    
   //**MU Parameters */
   double mu_tpt; 
-  std::vector<int> mu_ampdu;                            // List of MU AMPDUs for different stations 
-  Time mu_txdata, mu_Back;                               // MU Tx data and Ack 
-  Time mu_Pdl, mu_Pul;   
+  MuGroupScorer m_groupScorer;                          //!< throughput of the DL MU groups
+  bool m_enableTxopPlanning;                            //!< plan the sequence of PPDUs in a TXOP
+  TxopPlanner m_txopPlanner;                            //!< plans the PPDUs of a TXOP
+  std::deque<PlannedSuPpdu> m_txopPlan;                 //!< SU PPDUs to send in the rest of the TXOP
+  Time m_suReceiverAirtime;                             //!< airtime of the SU PPDU whose receiver is enforced (zero if none)
+  AcIndex m_txopPlanAc;                                 //!< AC of the TXOP the plan refers to
 
   //**SU Parameters */
   double su_tpt; 
-  std::list<CandidateInfo> m_candidates2;               //!< Candidate stations for SU TX
-  WifiTxParameters m_txParams2;                         //!< TX parameters for SU    
+  WifiTxParameters m_txParams2;                         //!< TX parameters for SU to the first candidate
   uint32_t su_ampdu;                                    // SU AMPDU 
-  Time su_txdata, su_Back;                               // SU Tx data and Ack
-  uint32_t pe = 16;  
-  Time su_Pdl, su_Pul;   
+  SuAmpduEstimate m_suEstimate;                         //!< A-MPDU estimated for SU
 
 };
 
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ru-layout.h"
+
+namespace ns3 {
+
+namespace {
+
+/// Layout of the RUs of a given type in a channel of a given width
+struct RuTypeLayout
+{
+  uint8_t nRus;                   //!< number of RUs in an 80 MHz segment (or in the channel, if narrower)
+  uint8_t nSegments;              //!< number of 80 MHz segments (2 in 160 MHz channels, 1 otherwise)
+  uint8_t nCentral26TonesRus;     //!< number of central 26-tone RUs in a segment
+  uint8_t central26TonesRus[5];   //!< indices of the central 26-tone RUs in a segment
+};
+
+/// Supported channel widths
+constexpr uint16_t WIDTHS[] = {20, 40, 80, 160};
+/// Number of supported channel widths
+constexpr std::size_t N_WIDTHS = 4;
+/// Number of RU types
+constexpr std::size_t N_RU_TYPES = HeRu::RU_2x996_TONE + 1;
+
+/// Layout of the RUs of all types for all the channel widths
+struct RuLayoutTable
+{
+  RuTypeLayout layouts[N_WIDTHS][N_RU_TYPES];  //!< indexed by width index and RU type
+};
+
+/**
+ * \param bw the channel width in MHz
+ * \param ruType the RU type
+ * \return the layout of the RUs of the given type in a channel of the given width
+ */
+constexpr RuTypeLayout
+MakeRuTypeLayout (uint16_t bw, HeRu::RuType ruType)
+{
+  RuTypeLayout layout {0, 1, 0, {0, 0, 0, 0, 0}};
+
+  if (ruType == HeRu::RU_2x996_TONE)
+    {
+      layout.nRus = (bw == 160 ? 1 : 0);
+      return layout;
+    }
+
+  uint16_t segmentBw = (bw == 160 ? 80 : bw);
+  layout.nSegments = (bw == 160 ? 2 : 1);
+
+  switch (ruType)
+    {
+      case HeRu::RU_26_TONE:
+        // nine 26-tone RUs per 20 MHz plus the one at the center of 80 MHz
+        layout.nRus = 9 * segmentBw / 20 + (segmentBw == 80 ? 1 : 0);
+        break;
+      case HeRu::RU_52_TONE:
+        layout.nRus = 4 * segmentBw / 20;
+        break;
+      case HeRu::RU_106_TONE:
+        layout.nRus = 2 * segmentBw / 20;
+        break;
+      case HeRu::RU_242_TONE:
+        layout.nRus = segmentBw / 20;
+        break;
+      case HeRu::RU_484_TONE:
+        layout.nRus = segmentBw / 40;
+        break;
+      case HeRu::RU_996_TONE:
+        layout.nRus = segmentBw / 80;
+        break;
+      default:
+        break;
+    }
+
+  // the 26-tone RUs that are not covered by the RUs of the given type, in
+  // the same order as HeRu::GetCentral26TonesRus: the ones at the center of
+  // every 20 MHz subchannel come first, followed by the one at the center of
+  // the 80 MHz segment
+  if (ruType == HeRu::RU_52_TONE || ruType == HeRu::RU_106_TONE)
+    {
+      const uint8_t indices[] = {5, 14, 24, 33};
+      layout.nCentral26TonesRus = segmentBw / 20;
+      for (std::size_t i = 0; i < layout.nCentral26TonesRus; i++)
+        {
+          layout.central26TonesRus[i] = indices[i];
+        }
+    }
+  if (ruType >= HeRu::RU_52_TONE && ruType <= HeRu::RU_484_TONE && segmentBw == 80)
+    {
+      layout.central26TonesRus[layout.nCentral26TonesRus++] = 19;
+    }
+  return layout;
+}
+
+/**
+ * \return the layout of the RUs of all types for all the channel widths
+ */
+constexpr RuLayoutTable
+MakeRuLayoutTable (void)
+{
+  RuLayoutTable table {};
+  for (std::size_t w = 0; w < N_WIDTHS; w++)
+    {
+      for (std::size_t t = 0; t < N_RU_TYPES; t++)
+        {
+          table.layouts[w][t] = MakeRuTypeLayout (WIDTHS[w], static_cast<HeRu::RuType> (t));
+        }
+    }
+  return table;
+}
+
+/// The RU layout table, generated at compile time
+constexpr RuLayoutTable RU_LAYOUT_TABLE = MakeRuLayoutTable ();
+
+static_assert (RU_LAYOUT_TABLE.layouts[0][HeRu::RU_26_TONE].nRus == 9, "9 26-tone RUs in 20 MHz");
+static_assert (RU_LAYOUT_TABLE.layouts[2][HeRu::RU_26_TONE].nRus == 37, "37 26-tone RUs in 80 MHz");
+static_assert (RU_LAYOUT_TABLE.layouts[3][HeRu::RU_106_TONE].nRus == 8
+               && RU_LAYOUT_TABLE.layouts[3][HeRu::RU_106_TONE].nSegments == 2,
+               "16 106-tone RUs in 160 MHz");
+static_assert (RU_LAYOUT_TABLE.layouts[1][HeRu::RU_52_TONE].nCentral26TonesRus == 2,
+               "2 central 26-tone RUs for 52-tone RUs in 40 MHz");
+static_assert (RU_LAYOUT_TABLE.layouts[2][HeRu::RU_106_TONE].nCentral26TonesRus == 5
+               && RU_LAYOUT_TABLE.layouts[2][HeRu::RU_106_TONE].central26TonesRus[0] == 5
+               && RU_LAYOUT_TABLE.layouts[2][HeRu::RU_106_TONE].central26TonesRus[1] == 14
+               && RU_LAYOUT_TABLE.layouts[2][HeRu::RU_106_TONE].central26TonesRus[2] == 24
+               && RU_LAYOUT_TABLE.layouts[2][HeRu::RU_106_TONE].central26TonesRus[3] == 33
+               && RU_LAYOUT_TABLE.layouts[2][HeRu::RU_106_TONE].central26TonesRus[4] == 19,
+               "central 26-tone RUs for 106-tone RUs in 80 MHz in the order of HeRu::GetCentral26TonesRus");
+static_assert (RU_LAYOUT_TABLE.layouts[3][HeRu::RU_52_TONE].central26TonesRus[4] == 19
+               && RU_LAYOUT_TABLE.layouts[3][HeRu::RU_484_TONE].nCentral26TonesRus == 1
+               && RU_LAYOUT_TABLE.layouts[3][HeRu::RU_484_TONE].central26TonesRus[0] == 19,
+               "the central 26-tone RU of an 80 MHz segment comes last");
+
+/**
+ * \param bw the channel width in MHz
+ * \param ruType the RU type
+ * \return the layout of the RUs of the given type in a channel of the given width
+ */
+const RuTypeLayout&
+GetRuTypeLayout (uint16_t bw, HeRu::RuType ruType)
+{
+  std::size_t w = 0;
+  switch (bw)
+    {
+      case 20:
+        w = 0;
+        break;
+      case 40:
+        w = 1;
+        break;
+      case 80:
+        w = 2;
+        break;
+      case 160:
+        w = 3;
+        break;
+      default:
+        NS_ABORT_MSG ("Unsupported channel width: " << bw << " MHz");
+    }
+  NS_ASSERT (ruType < N_RU_TYPES);
+  return RU_LAYOUT_TABLE.layouts[w][ruType];
+}
+
+} // unnamed namespace
+
+std::size_t
+RuLayout::GetNRus (uint16_t bw, HeRu::RuType ruType)
+{
+  const RuTypeLayout& layout = GetRuTypeLayout (bw, ruType);
+  return layout.nRus * layout.nSegments;
+}
+
+HeRu::RuSpec
+RuLayout::GetRu (uint16_t bw, HeRu::RuType ruType, std::size_t pos)
+{
+  const RuTypeLayout& layout = GetRuTypeLayout (bw, ruType);
+  NS_ASSERT (pos < static_cast<std::size_t> (layout.nRus * layout.nSegments));
+  return HeRu::RuSpec {ruType, pos % layout.nRus + 1, pos < layout.nRus};
+}
+
+std::size_t
+RuLayout::GetNCentral26TonesRus (uint16_t bw, HeRu::RuType ruType)
+{
+  const RuTypeLayout& layout = GetRuTypeLayout (bw, ruType);
+  return layout.nCentral26TonesRus * layout.nSegments;
+}
+
+HeRu::RuSpec
+RuLayout::GetCentral26TonesRu (uint16_t bw, HeRu::RuType ruType, std::size_t pos)
+{
+  const RuTypeLayout& layout = GetRuTypeLayout (bw, ruType);
+  NS_ASSERT (pos < static_cast<std::size_t> (layout.nCentral26TonesRus * layout.nSegments));
+  return HeRu::RuSpec {HeRu::RU_26_TONE,
+                       layout.central26TonesRus[pos % layout.nCentral26TonesRus],
+                       pos < layout.nCentral26TonesRus};
+}
+
+} //namespace ns3
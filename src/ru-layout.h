@@ -0,0 +1,68 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RU_LAYOUT_H
+#define RU_LAYOUT_H
+
+#include "he-ru.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * RuLayout provides the RUs of every type and the central 26-tone RUs for
+ * every channel width (20, 40, 80 and 160 MHz) by means of a table generated
+ * at compile time, so that RUs can be enumerated without allocating memory.
+ * RUs are enumerated in the same order as HeRu::GetRusOfType and
+ * HeRu::GetCentral26TonesRus, i.e., RUs in the primary 80 MHz come first in
+ * 160 MHz channels.
+ */
+class RuLayout
+{
+public:
+  /**
+   * \param bw the channel width in MHz
+   * \param ruType the RU type
+   * \return the number of RUs of the given type in a channel of the given width
+   */
+  static std::size_t GetNRus (uint16_t bw, HeRu::RuType ruType);
+  /**
+   * \param bw the channel width in MHz
+   * \param ruType the RU type
+   * \param pos the position of the RU among the RUs of the given type
+   * \return the RU at the given position
+   */
+  static HeRu::RuSpec GetRu (uint16_t bw, HeRu::RuType ruType, std::size_t pos);
+  /**
+   * \param bw the channel width in MHz
+   * \param ruType the type of the RUs allocated along with central 26-tone RUs
+   * \return the number of central 26-tone RUs that can be allocated along with
+   *         RUs of the given type in a channel of the given width
+   */
+  static std::size_t GetNCentral26TonesRus (uint16_t bw, HeRu::RuType ruType);
+  /**
+   * \param bw the channel width in MHz
+   * \param ruType the type of the RUs allocated along with central 26-tone RUs
+   * \param pos the position of the RU among the central 26-tone RUs
+   * \return the central 26-tone RU at the given position
+   */
+  static HeRu::RuSpec GetCentral26TonesRu (uint16_t bw, HeRu::RuType ruType, std::size_t pos);
+};
+
+} //namespace ns3
+
+#endif /* RU_LAYOUT_H */
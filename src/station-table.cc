@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "station-table.h"
+#include <limits>
+
+namespace ns3 {
+
+const std::size_t StationTable::NONE = std::numeric_limits<std::size_t>::max ();
+
+StationTable::StationTable ()
+  : m_nHeStations (0)
+{
+}
+
+std::size_t
+StationTable::Add (uint16_t aid, Mac48Address address, bool heSupported)
+{
+  NS_ASSERT (aid != 0);
+  NS_ASSERT (m_slots.find (address) == m_slots.end ());
+
+  std::size_t slot;
+
+  if (!m_free.empty ())
+    {
+      slot = m_free.back ();
+      m_free.pop_back ();
+    }
+  else
+    {
+      slot = m_aid.size ();
+      m_aid.push_back (0);
+      m_address.push_back (Mac48Address ());
+      m_heSupported.push_back (0);
+      m_txVector.push_back (WifiTxVector ());
+    }
+
+  m_aid[slot] = aid;
+  m_address[slot] = address;
+  m_heSupported[slot] = heSupported;
+  m_txVector[slot] = WifiTxVector ();
+  m_slots[address] = slot;
+
+  if (heSupported)
+    {
+      for (auto& credits : m_credits)
+        {
+          credits.Insert (slot, 0.0);
+        }
+      m_nHeStations++;
+    }
+  return slot;
+}
+
+void
+StationTable::Remove (std::size_t slot)
+{
+  NS_ASSERT (slot < m_aid.size () && m_aid[slot] != 0);
+
+  if (m_heSupported[slot])
+    {
+      for (auto& credits : m_credits)
+        {
+          credits.Remove (slot);
+        }
+      m_nHeStations--;
+    }
+  m_slots.erase (m_address[slot]);
+  m_aid[slot] = 0;
+  m_txVector[slot] = WifiTxVector ();
+  m_free.push_back (slot);
+}
+
+void
+StationTable::Clear (void)
+{
+  m_aid.clear ();
+  m_address.clear ();
+  m_heSupported.clear ();
+  m_txVector.clear ();
+  m_free.clear ();
+  m_slots.clear ();
+  for (auto& credits : m_credits)
+    {
+      credits.Clear ();
+    }
+  m_nHeStations = 0;
+}
+
+void
+StationTable::SetEligible (std::size_t slot, bool eligible)
+{
+  NS_ASSERT (slot < m_aid.size () && m_aid[slot] != 0);
+
+  if (m_heSupported[slot])
+    {
+      for (auto& credits : m_credits)
+        {
+          credits.SetActive (slot, eligible);
+        }
+    }
+}
+
+std::size_t
+StationTable::Find (Mac48Address address) const
+{
+  auto it = m_slots.find (address);
+  return (it != m_slots.end () ? it->second : NONE);
+}
+
+uint16_t
+StationTable::GetAid (std::size_t slot) const
+{
+  NS_ASSERT (slot < m_aid.size ());
+  return m_aid[slot];
+}
+
+Mac48Address
+StationTable::GetAddress (std::size_t slot) const
+{
+  NS_ASSERT (slot < m_address.size ());
+  return m_address[slot];
+}
+
+bool
+StationTable::IsHeSupported (std::size_t slot) const
+{
+  NS_ASSERT (slot < m_heSupported.size ());
+  return m_heSupported[slot];
+}
+
+const WifiTxVector&
+StationTable::GetTxVector (std::size_t slot) const
+{
+  NS_ASSERT (slot < m_txVector.size ());
+  return m_txVector[slot];
+}
+
+void
+StationTable::SetTxVector (std::size_t slot, const WifiTxVector& txVector)
+{
+  NS_ASSERT (slot < m_txVector.size ());
+  m_txVector[slot] = txVector;
+}
+
+CreditHeap&
+StationTable::GetCredits (AcIndex ac)
+{
+  NS_ASSERT (ac < AC_BE_NQOS);
+  return m_credits[ac];
+}
+
+std::size_t
+StationTable::GetNStations (void) const
+{
+  return m_slots.size ();
+}
+
+std::size_t
+StationTable::GetNHeStations (void) const
+{
+  return m_nHeStations;
+}
+
+} //namespace ns3
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef STATION_TABLE_H
+#define STATION_TABLE_H
+
+#include "ns3/mac48-address.h"
+#include "ns3/qos-utils.h"
+#include "ns3/wifi-tx-vector.h"
+#include "credit-heap.h"
+#include <array>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * StationTable stores the stations associated with an AP in a struct-of-arrays
+ * layout: every station is identified by a slot and each of its attributes
+ * (AID, MAC address, HE support, last TX vector) is stored in a separate array
+ * indexed by the slot. Slots of deassociated stations are reused, hence the
+ * size of the arrays is bounded by the maximum number of stations associated
+ * at the same time.
+ *
+ * Every Access Category has a view of the table containing the HE stations,
+ * which is a CreditHeap indexed by the slots of the table. Adding or removing
+ * a station, as well as marking it as eligible, updates all the views at once.
+ */
+class StationTable
+{
+public:
+  StationTable ();
+
+  static const std::size_t NONE;    //!< slot returned when a station is not found
+
+  /**
+   * Add a station. HE stations are also added to the view of every AC with
+   * zero credits.
+   *
+   * \param aid the AID of the station
+   * \param address the MAC address of the station
+   * \param heSupported whether the station supports HE
+   * \return the slot assigned to the station
+   */
+  std::size_t Add (uint16_t aid, Mac48Address address, bool heSupported);
+  /**
+   * Remove a station.
+   *
+   * \param slot the slot of the station
+   */
+  void Remove (std::size_t slot);
+  /**
+   * Remove all the stations.
+   */
+  void Clear (void);
+  /**
+   * Set whether the given station can be served in a DL MU PPDU (i.e., the AP
+   * has frames queued for the station under a Block Ack agreement), which
+   * makes the station active in the view of every AC. Stations are added as
+   * not eligible. Non-HE stations are ignored.
+   *
+   * \param slot the slot of the station
+   * \param eligible whether the station can be served in a DL MU PPDU
+   */
+  void SetEligible (std::size_t slot, bool eligible);
+  /**
+   * \param address the MAC address of a station
+   * \return the slot of the station or NONE if the station is not in the table
+   */
+  std::size_t Find (Mac48Address address) const;
+
+  /**
+   * \param slot the slot of a station
+   * \return the AID of the station
+   */
+  uint16_t GetAid (std::size_t slot) const;
+  /**
+   * \param slot the slot of a station
+   * \return the MAC address of the station
+   */
+  Mac48Address GetAddress (std::size_t slot) const;
+  /**
+   * \param slot the slot of a station
+   * \return whether the station supports HE
+   */
+  bool IsHeSupported (std::size_t slot) const;
+  /**
+   * \param slot the slot of a station
+   * \return the TX vector last used to evaluate an SU transmission to the station
+   */
+  const WifiTxVector& GetTxVector (std::size_t slot) const;
+  /**
+   * \param slot the slot of a station
+   * \param txVector the TX vector used to evaluate an SU transmission to the station
+   */
+  void SetTxVector (std::size_t slot, const WifiTxVector& txVector);
+
+  /**
+   * \param ac the Access Category
+   * \return the credits accumulated by the HE stations for the given AC
+   */
+  CreditHeap& GetCredits (AcIndex ac);
+  /**
+   * \return the number of stations in the table
+   */
+  std::size_t GetNStations (void) const;
+  /**
+   * \return the number of HE stations in the table
+   */
+  std::size_t GetNHeStations (void) const;
+
+private:
+  std::vector<uint16_t> m_aid;                      //!< AID of each slot (0 if the slot is free)
+  std::vector<Mac48Address> m_address;              //!< MAC address of each slot
+  std::vector<uint8_t> m_heSupported;               //!< HE support of each slot
+  std::vector<WifiTxVector> m_txVector;             //!< last TX vector of each slot
+  std::vector<std::size_t> m_free;                  //!< free slots
+  std::map<Mac48Address, std::size_t> m_slots;      //!< slot of every station
+  std::array<CreditHeap, AC_BE_NQOS> m_credits;     //!< per-AC view of the HE stations
+  std::size_t m_nHeStations;                        //!< number of HE stations
+};
+
+} //namespace ns3
+
+#endif /* STATION_TABLE_H */
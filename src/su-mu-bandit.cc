@@ -0,0 +1,423 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "su-mu-bandit.h"
+#include "he-frame-exchange-manager.h"
+#include "wifi-psdu.h"
+#include "wifi-mac-queue-item.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SuMuBandit");
+
+NS_OBJECT_ENSURE_REGISTERED (SuMuBandit);
+
+TypeId
+SuMuBandit::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SuMuBandit")
+    .SetParent<SuMuSelectionPolicy> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<SuMuBandit> ()
+    .AddAttribute ("Exploration",
+                   "The weight of the exploration bonus, relative to the highest mean "
+                   "reward of the context.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&SuMuBandit::m_exploration),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("Discount",
+                   "The factor by which past rewards of a context are discounted every "
+                   "time a pull of that context completes (1 means no discount).",
+                   DoubleValue (0.99),
+                   MakeDoubleAccessor (&SuMuBandit::m_discount),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxFeedbackDelay",
+                   "The time after which a pull is completed even if some of its "
+                   "MPDUs have not been acknowledged or reported as lost.",
+                   TimeValue (MilliSeconds (50)),
+                   MakeTimeAccessor (&SuMuBandit::m_maxFeedbackDelay),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+SuMuBandit::SuMuBandit ()
+  : m_nextPullId (0),
+    m_bindNextPsdu (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SuMuBandit::~SuMuBandit ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SuMuBandit::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Detach ();
+  m_stats.clear ();
+  m_pulls.clear ();
+  m_mpduToPull.clear ();
+  SuMuSelectionPolicy::DoDispose ();
+}
+
+void
+SuMuBandit::Attach (Ptr<ApWifiMac> apMac, Ptr<HeFrameExchangeManager> heFem)
+{
+  NS_LOG_FUNCTION (this << apMac << heFem);
+
+  Detach ();
+  m_apMac = apMac;
+  m_heFem = heFem;
+  m_heFem->TraceConnectWithoutContext ("PsduForwardDown",
+                                       MakeCallback (&SuMuBandit::NotifyPsduForwardedDown, this));
+  m_heFem->TraceConnectWithoutContext ("PsduMapForwardDown",
+                                       MakeCallback (&SuMuBandit::NotifyPsduMapForwardedDown, this));
+  m_apMac->TraceConnectWithoutContext ("AckedMpdu", MakeCallback (&SuMuBandit::NotifyAcked, this));
+  m_apMac->TraceConnectWithoutContext ("NAckedMpdu", MakeCallback (&SuMuBandit::NotifyNAcked, this));
+}
+
+void
+SuMuBandit::Detach (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_heFem != 0)
+    {
+      m_heFem->TraceDisconnectWithoutContext ("PsduForwardDown",
+                                              MakeCallback (&SuMuBandit::NotifyPsduForwardedDown, this));
+      m_heFem->TraceDisconnectWithoutContext ("PsduMapForwardDown",
+                                              MakeCallback (&SuMuBandit::NotifyPsduMapForwardedDown, this));
+      m_heFem = 0;
+    }
+  if (m_apMac != 0)
+    {
+      m_apMac->TraceDisconnectWithoutContext ("AckedMpdu", MakeCallback (&SuMuBandit::NotifyAcked, this));
+      m_apMac->TraceDisconnectWithoutContext ("NAckedMpdu", MakeCallback (&SuMuBandit::NotifyNAcked, this));
+      m_apMac = 0;
+    }
+}
+
+SuMuBandit::Context
+SuMuBandit::GetContext (std::size_t nCandidates, uint32_t nQueuedPackets, uint8_t mcs)
+{
+  auto bucket = [] (uint64_t value)
+    {
+      uint8_t b = 0;
+      while (value > 1)
+        {
+          value >>= 1;
+          b++;
+        }
+      return b;
+    };
+  return std::make_tuple (bucket (nCandidates), bucket (nQueuedPackets), mcs);
+}
+
+MultiUserScheduler::TxFormat
+SuMuBandit::Select (const SuMuSnapshot& snapshot)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint8_t mcs = (snapshot.candidates.empty () ? 0 : snapshot.candidates.front ().mcs);
+  Context context = GetContext (snapshot.candidates.size (), snapshot.nQueuedPackets, mcs);
+  // the analytic choice is the starting point
+  Arm arm = SelectArm (context, (snapshot.suThroughput > snapshot.muThroughput ? SU : MU));
+  NotifyDecision (context, arm, snapshot.accessTime);
+  return (arm == SU ? MultiUserScheduler::SU_TX : MultiUserScheduler::DL_MU_TX);
+}
+
+SuMuBandit::Arm
+SuMuBandit::SelectArm (const Context& context, Arm defaultArm)
+{
+  NS_LOG_FUNCTION (this << +std::get<0> (context) << +std::get<1> (context)
+                   << +std::get<2> (context) << +defaultArm);
+
+  CompleteStalePulls ();
+
+  auto it = m_stats.find (context);
+  if (it == m_stats.end ())
+    {
+      return defaultArm;
+    }
+
+  const ArmStats& stats = it->second;
+  double total = 0;
+  double maxMean = 0;
+  for (uint8_t arm = 0; arm < N_ARMS; arm++)
+    {
+      if (stats.count[arm] == 0)
+        {
+          // every arm is pulled at least once
+          return static_cast<Arm> (arm);
+        }
+      total += stats.count[arm];
+      maxMean = std::max (maxMean, stats.reward[arm] / stats.count[arm]);
+    }
+
+  Arm best = defaultArm;
+  double bestIndex = -1;
+  for (uint8_t arm = 0; arm < N_ARMS; arm++)
+    {
+      double index = stats.reward[arm] / stats.count[arm]
+                     + m_exploration * maxMean * std::sqrt (2 * std::log (std::max (total, 1.0))
+                                                            / stats.count[arm]);
+      NS_LOG_DEBUG ("Arm " << +arm << ": mean=" << stats.reward[arm] / stats.count[arm]
+                    << " Mbps, index=" << index);
+      if (index > bestIndex)
+        {
+          best = static_cast<Arm> (arm);
+          bestIndex = index;
+        }
+    }
+  return best;
+}
+
+void
+SuMuBandit::NotifyDecision (const Context& context, Arm arm, Time accessTime)
+{
+  NS_LOG_FUNCTION (this << +arm << accessTime);
+
+  if (m_bindNextPsdu)
+    {
+      // the last pull has not been bound to any PPDU
+      auto it = m_pulls.find (m_nextPullId - 1);
+      if (it != m_pulls.end () && it->second.nPending == 0)
+        {
+          ErasePull (it);
+        }
+    }
+
+  Pull& pull = m_pulls[m_nextPullId++];
+  pull.context = context;
+  pull.arm = arm;
+  pull.start = Simulator::Now ();
+  pull.accessTime = accessTime;
+  pull.lastFeedback = pull.start;
+  m_bindNextPsdu = true;
+}
+
+void
+SuMuBandit::NotifyPsduForwardedDown (Ptr<const WifiPsdu> psdu, WifiTxVector txVector)
+{
+  NS_LOG_FUNCTION (this << *psdu << txVector);
+
+  if (!txVector.IsMu ())
+    {
+      BindPsdu (psdu);
+      EndPpdu ();
+    }
+}
+
+void
+SuMuBandit::NotifyPsduMapForwardedDown (WifiConstPsduMap psduMap, WifiTxVector txVector)
+{
+  NS_LOG_FUNCTION (this << txVector);
+
+  for (const auto& psdu : psduMap)
+    {
+      BindPsdu (psdu.second);
+    }
+  EndPpdu ();
+}
+
+void
+SuMuBandit::BindPsdu (Ptr<const WifiPsdu> psdu)
+{
+  NS_LOG_FUNCTION (this << *psdu);
+
+  if (!m_bindNextPsdu)
+    {
+      return;
+    }
+
+  uint64_t pullId = m_nextPullId - 1;
+  auto pullIt = m_pulls.find (pullId);
+  if (pullIt == m_pulls.end ())
+    {
+      return;
+    }
+
+  for (const auto& mpdu : *PeekPointer (psdu))
+    {
+      if (!mpdu->GetHeader ().IsQosData ())
+        {
+          continue;
+        }
+      auto it = m_mpduToPull.find (mpdu->GetPacket ()->GetUid ());
+      if (it != m_mpduToPull.end ())
+        {
+          // the MPDU is being retransmitted, hence it no longer counts for the
+          // pull it was previously bound to
+          auto prevIt = m_pulls.find (it->second);
+          if (prevIt != m_pulls.end () && prevIt->second.nPending > 0)
+            {
+              prevIt->second.nPending--;
+            }
+          it->second = pullId;
+        }
+      else
+        {
+          m_mpduToPull.emplace (mpdu->GetPacket ()->GetUid (), pullId);
+        }
+      pullIt->second.nPending++;
+      pullIt->second.mpdus.push_back (mpdu->GetPacket ()->GetUid ());
+    }
+}
+
+void
+SuMuBandit::EndPpdu (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  auto it = m_pulls.find (m_nextPullId - 1);
+  if (m_bindNextPsdu && it != m_pulls.end () && it->second.nPending > 0)
+    {
+      m_bindNextPsdu = false;
+    }
+}
+
+void
+SuMuBandit::NotifyAcked (Ptr<const WifiMacQueueItem> mpdu)
+{
+  NotifyFeedback (mpdu, true);
+}
+
+void
+SuMuBandit::NotifyNAcked (Ptr<const WifiMacQueueItem> mpdu)
+{
+  NotifyFeedback (mpdu, false);
+}
+
+void
+SuMuBandit::NotifyFeedback (Ptr<const WifiMacQueueItem> mpdu, bool acked)
+{
+  NS_LOG_FUNCTION (this << *mpdu << acked);
+
+  auto it = m_mpduToPull.find (mpdu->GetPacket ()->GetUid ());
+  if (it == m_mpduToPull.end ())
+    {
+      return;
+    }
+  uint64_t pullId = it->second;
+  m_mpduToPull.erase (it);
+
+  auto pullIt = m_pulls.find (pullId);
+  if (pullIt == m_pulls.end ())
+    {
+      return;
+    }
+
+  Pull& pull = pullIt->second;
+  if (acked)
+    {
+      pull.ackedBytes += mpdu->GetPacketSize ();
+    }
+  pull.lastFeedback = Simulator::Now ();
+  NS_ASSERT (pull.nPending > 0);
+  if (--pull.nPending == 0 && !(m_bindNextPsdu && pullId == m_nextPullId - 1))
+    {
+      CompletePull (pullId);
+    }
+}
+
+void
+SuMuBandit::CompletePull (uint64_t pullId)
+{
+  NS_LOG_FUNCTION (this << pullId);
+
+  auto it = m_pulls.find (pullId);
+  NS_ASSERT (it != m_pulls.end ());
+  const Pull& pull = it->second;
+
+  Time duration = pull.lastFeedback - pull.start + pull.accessTime;
+  if (duration.IsStrictlyPositive ())
+    {
+      double reward = pull.ackedBytes * 8.0 / duration.ToDouble (Time::US);
+      ArmStats& stats = m_stats[pull.context];
+      for (uint8_t arm = 0; arm < N_ARMS; arm++)
+        {
+          stats.count[arm] *= m_discount;
+          stats.reward[arm] *= m_discount;
+        }
+      stats.count[pull.arm] += 1;
+      stats.reward[pull.arm] += reward;
+      NS_LOG_DEBUG ("Pull of arm " << +pull.arm << " delivered " << pull.ackedBytes
+                    << " bytes in " << duration.As (Time::US) << " (" << reward << " Mbps)");
+    }
+  ErasePull (it);
+}
+
+void
+SuMuBandit::CompleteStalePulls (void)
+{
+  Time now = Simulator::Now ();
+
+  for (auto it = m_pulls.begin (); it != m_pulls.end (); )
+    {
+      auto next = std::next (it);
+      if (now - it->second.lastFeedback > m_maxFeedbackDelay)
+        {
+          if (it->second.nPending > 0)
+            {
+              CompletePull (it->first);
+            }
+          else
+            {
+              ErasePull (it);
+            }
+        }
+      it = next;
+    }
+}
+
+void
+SuMuBandit::ErasePull (Pulls::iterator it)
+{
+  NS_LOG_FUNCTION (this << it->first);
+
+  // MPDUs retransmitted in a later pull are bound to that pull
+  for (uint64_t uid : it->second.mpdus)
+    {
+      auto mpduIt = m_mpduToPull.find (uid);
+      if (mpduIt != m_mpduToPull.end () && mpduIt->second == it->first)
+        {
+          m_mpduToPull.erase (mpduIt);
+        }
+    }
+  m_pulls.erase (it);
+}
+
+double
+SuMuBandit::GetMeanReward (const Context& context, Arm arm) const
+{
+  auto it = m_stats.find (context);
+  if (it == m_stats.end () || it->second.count[arm] == 0)
+    {
+      return 0.0;
+    }
+  return it->second.reward[arm] / it->second.count[arm];
+}
+
+} //namespace ns3
@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SU_MU_BANDIT_H
+#define SU_MU_BANDIT_H
+
+#include "su-mu-selection-policy.h"
+#include "wifi-ppdu.h"
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+class WifiPsdu;
+class WifiMacQueueItem;
+
+/**
+ * \ingroup wifi
+ *
+ * SuMuBandit is a selection policy that learns online which of SU and DL MU
+ * transmissions delivers more goodput, by treating the choice as a two-armed
+ * bandit whose context is the number of candidate stations, the number of
+ * queued packets and the MCS of the first candidate (the two counts are
+ * bucketed on a logarithmic scale).
+ *
+ * Every decision opens a pull, to which the QoS data MPDUs of the next PPDU
+ * (SU or DL MU) carrying any are bound. The pull completes when all of its
+ * MPDUs have been either acknowledged or not (or after the MaxFeedbackDelay
+ * attribute has elapsed) and its reward is the number of bytes acknowledged
+ * divided by the time elapsed from the decision to the last feedback plus the
+ * expected channel access time, so that failed transmissions, retries and
+ * acknowledgment overhead are accounted for.
+ *
+ * Arms are selected by the discounted UCB1 policy: in a context never seen
+ * before, the format with the highest predicted throughput is selected; then
+ * every arm is pulled once and, afterwards, the arm with the highest mean
+ * reward plus an exploration bonus is selected. The bonus is scaled by the
+ * highest mean reward of the context, so that the Exploration attribute does
+ * not depend on the throughput range. Past rewards are discounted by the
+ * Discount attribute every time a pull of the same context completes, so that
+ * the selection tracks changes in the traffic and in the channel.
+ */
+class SuMuBandit : public SuMuSelectionPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SuMuBandit ();
+  virtual ~SuMuBandit ();
+
+  /**
+   * The arms of the bandit
+   */
+  enum Arm : uint8_t
+  {
+    SU = 0,     //!< HE SU PPDU
+    MU,         //!< DL MU PPDU
+    N_ARMS      //!< number of arms
+  };
+
+  /// Context of a decision: candidate bucket, backlog bucket and MCS
+  typedef std::tuple<uint8_t, uint8_t, uint8_t> Context;
+
+  /**
+   * \param nCandidates the number of candidate stations
+   * \param nQueuedPackets the number of packets queued by the AP
+   * \param mcs the MCS of the first candidate station
+   * \return the context of a decision taken in the given conditions
+   */
+  static Context GetContext (std::size_t nCandidates, uint32_t nQueuedPackets, uint8_t mcs);
+
+  MultiUserScheduler::TxFormat Select (const SuMuSnapshot& snapshot) override;
+  void Attach (Ptr<ApWifiMac> apMac, Ptr<HeFrameExchangeManager> heFem) override;
+  void Detach (void) override;
+
+  /**
+   * \param context a context
+   * \param arm an arm
+   * \return the (discounted) mean reward of the given arm in the given context,
+   *         in Mbps, or zero if the arm has never been pulled
+   */
+  double GetMeanReward (const Context& context, Arm arm) const;
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  /// Discounted statistics of the arms of a context
+  struct ArmStats
+  {
+    double count[N_ARMS] {0.0, 0.0};   //!< discounted number of pulls
+    double reward[N_ARMS] {0.0, 0.0};  //!< discounted sum of rewards
+  };
+
+  /// A pull whose reward is not known yet
+  struct Pull
+  {
+    Context context;           //!< context of the decision
+    Arm arm;                   //!< selected arm
+    Time start;                //!< time of the decision
+    Time accessTime;           //!< expected channel access time
+    Time lastFeedback;         //!< time of the last feedback received
+    uint32_t nPending {0};     //!< number of MPDUs without feedback
+    uint64_t ackedBytes {0};   //!< bytes acknowledged
+    std::vector<uint64_t> mpdus; //!< packet UIDs of the MPDUs bound to the pull
+  };
+
+  /// Pulls indexed by ID
+  typedef std::map<uint64_t, Pull> Pulls;
+
+  /**
+   * Select an arm for the given context.
+   *
+   * \param context the context of the decision
+   * \param defaultArm the arm selected if the context has never been seen
+   * \return the selected arm
+   */
+  Arm SelectArm (const Context& context, Arm defaultArm);
+
+  /**
+   * Open a pull of the given arm for the given context.
+   *
+   * \param context the context of the decision
+   * \param arm the selected arm
+   * \param accessTime the expected time to access the channel, which is added
+   *        to the duration of the pull
+   */
+  void NotifyDecision (const Context& context, Arm arm, Time accessTime);
+
+  /**
+   * Bind the QoS data MPDUs of the given PSDU to the last pull, if the
+   * last pull has not been bound to a PPDU yet.
+   *
+   * \param psdu the PSDU
+   */
+  void BindPsdu (Ptr<const WifiPsdu> psdu);
+
+  /**
+   * Stop binding PSDUs to the last pull if the PPDU just transmitted
+   * carried QoS data MPDUs.
+   */
+  void EndPpdu (void);
+
+  /**
+   * Notify that a PSDU has been forwarded down to the PHY.
+   *
+   * \param psdu the PSDU
+   * \param txVector the TX vector used to transmit the PSDU
+   */
+  void NotifyPsduForwardedDown (Ptr<const WifiPsdu> psdu, WifiTxVector txVector);
+
+  /**
+   * Notify that a PSDU map has been forwarded down to the PHY.
+   *
+   * \param psduMap the PSDU map
+   * \param txVector the TX vector used to transmit the PSDU map
+   */
+  void NotifyPsduMapForwardedDown (WifiConstPsduMap psduMap, WifiTxVector txVector);
+
+  /**
+   * Notify that the given MPDU has been acknowledged.
+   *
+   * \param mpdu the MPDU
+   */
+  void NotifyAcked (Ptr<const WifiMacQueueItem> mpdu);
+
+  /**
+   * Notify that the given MPDU has not been acknowledged.
+   *
+   * \param mpdu the MPDU
+   */
+  void NotifyNAcked (Ptr<const WifiMacQueueItem> mpdu);
+
+  /**
+   * Process the feedback for the given MPDU.
+   *
+   * \param mpdu the MPDU
+   * \param acked whether the MPDU has been acknowledged
+   */
+  void NotifyFeedback (Ptr<const WifiMacQueueItem> mpdu, bool acked);
+
+  /**
+   * Compute the reward of the given pull and update the statistics of its context.
+   *
+   * \param pullId the ID of the pull
+   */
+  void CompletePull (uint64_t pullId);
+
+  /**
+   * Complete the pulls that have not received feedback for longer than
+   * MaxFeedbackDelay.
+   */
+  void CompleteStalePulls (void);
+
+  /**
+   * Remove the given pull along with the MPDUs still bound to it, e.g.,
+   * MPDUs dropped without any feedback.
+   *
+   * \param it an iterator to the pull
+   */
+  void ErasePull (Pulls::iterator it);
+
+  double m_exploration;                  //!< weight of the exploration bonus
+  double m_discount;                     //!< discount factor of past rewards
+  Time m_maxFeedbackDelay;               //!< max time to wait for feedback
+  Ptr<ApWifiMac> m_apMac;                //!< the MAC of the AP
+  Ptr<HeFrameExchangeManager> m_heFem;   //!< the HE FEM of the AP
+  std::map<Context, ArmStats> m_stats;   //!< per-context statistics
+  Pulls m_pulls;                         //!< pulls whose reward is not known yet
+  std::unordered_map<uint64_t, uint64_t> m_mpduToPull; //!< pull of every MPDU, by packet UID
+  uint64_t m_nextPullId;                 //!< ID of the next pull
+  bool m_bindNextPsdu;                   //!< whether the next PSDUs belong to the last pull
+};
+
+} //namespace ns3
+
+#endif /* SU_MU_BANDIT_H */
@@ -0,0 +1,343 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "su-mu-selection-policy.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SuMuSelectionPolicy");
+
+NS_OBJECT_ENSURE_REGISTERED (SuMuSelectionPolicy);
+
+TypeId
+SuMuSelectionPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SuMuSelectionPolicy")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+  ;
+  return tid;
+}
+
+SuMuSelectionPolicy::SuMuSelectionPolicy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SuMuSelectionPolicy::~SuMuSelectionPolicy ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SuMuSelectionPolicy::Attach (Ptr<ApWifiMac> apMac, Ptr<HeFrameExchangeManager> heFem)
+{
+  NS_LOG_FUNCTION (this << apMac << heFem);
+}
+
+void
+SuMuSelectionPolicy::Detach (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+SuMuSelectionPolicy::CanReuseDecision (void) const
+{
+  return false;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (ThroughputSelectionPolicy);
+
+TypeId
+ThroughputSelectionPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ThroughputSelectionPolicy")
+    .SetParent<SuMuSelectionPolicy> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<ThroughputSelectionPolicy> ()
+  ;
+  return tid;
+}
+
+MultiUserScheduler::TxFormat
+ThroughputSelectionPolicy::Select (const SuMuSnapshot& snapshot)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (snapshot.txopPlanned)
+    {
+      // the plan already maximizes the bytes delivered in the TXOP
+      return (snapshot.plannedMuGroupSize == 0 ? MultiUserScheduler::SU_TX
+                                                : MultiUserScheduler::DL_MU_TX);
+    }
+  return (snapshot.suThroughput > snapshot.muThroughput ? MultiUserScheduler::SU_TX
+                                                        : MultiUserScheduler::DL_MU_TX);
+}
+
+bool
+ThroughputSelectionPolicy::CanReuseDecision (void) const
+{
+  return true;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (QueueOccupancySelectionPolicy);
+
+TypeId
+QueueOccupancySelectionPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::QueueOccupancySelectionPolicy")
+    .SetParent<SuMuSelectionPolicy> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<QueueOccupancySelectionPolicy> ()
+    .AddAttribute ("Threshold",
+                   "The fraction of the queue occupied by packets above which SU is selected.",
+                   DoubleValue (0.6),
+                   MakeDoubleAccessor (&QueueOccupancySelectionPolicy::m_threshold),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+MultiUserScheduler::TxFormat
+QueueOccupancySelectionPolicy::Select (const SuMuSnapshot& snapshot)
+{
+  NS_LOG_FUNCTION (this);
+
+  double occupancy = (snapshot.queueCapacity > 0
+                      ? static_cast<double> (snapshot.nQueuedPackets) / snapshot.queueCapacity
+                      : 0.0);
+  NS_LOG_DEBUG ("Queue occupancy: " << occupancy);
+  return (occupancy > m_threshold ? MultiUserScheduler::SU_TX : MultiUserScheduler::DL_MU_TX);
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LatencyTargetSelectionPolicy);
+
+TypeId
+LatencyTargetSelectionPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LatencyTargetSelectionPolicy")
+    .SetParent<SuMuSelectionPolicy> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<LatencyTargetSelectionPolicy> ()
+    .AddAttribute ("Target",
+                   "The time within which all the candidate stations should be served.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&LatencyTargetSelectionPolicy::m_target),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+MultiUserScheduler::TxFormat
+LatencyTargetSelectionPolicy::Select (const SuMuSnapshot& snapshot)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::size_t nCandidates = snapshot.candidates.size ();
+  Time suLatency = (snapshot.accessTime + snapshot.suAirtime) * static_cast<int64_t> (nCandidates);
+  Time muLatency = snapshot.muAirtime + snapshot.accessTime;
+  if (snapshot.muGroupSize > 0)
+    {
+      muLatency = muLatency * static_cast<int64_t> ((nCandidates + snapshot.muGroupSize - 1)
+                                                    / snapshot.muGroupSize);
+    }
+  NS_LOG_DEBUG ("Time to serve the candidates: SU=" << suLatency.As (Time::US)
+                << ", DL MU=" << muLatency.As (Time::US));
+
+  MultiUserScheduler::TxFormat format = (snapshot.suThroughput > snapshot.muThroughput
+                                         ? MultiUserScheduler::SU_TX : MultiUserScheduler::DL_MU_TX);
+  Time latency = (format == MultiUserScheduler::SU_TX ? suLatency : muLatency);
+  Time otherLatency = (format == MultiUserScheduler::SU_TX ? muLatency : suLatency);
+
+  if (latency > m_target && otherLatency < latency)
+    {
+      // the other format serves the candidates sooner
+      format = (format == MultiUserScheduler::SU_TX ? MultiUserScheduler::DL_MU_TX
+                                                    : MultiUserScheduler::SU_TX);
+    }
+  return format;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LatencyAwareSelectionPolicy);
+
+TypeId
+LatencyAwareSelectionPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LatencyAwareSelectionPolicy")
+    .SetParent<SuMuSelectionPolicy> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<LatencyAwareSelectionPolicy> ()
+    .AddAttribute ("Objective",
+                   "The objective computed on the predicted delays of the candidates.",
+                   EnumValue (LatencyAwareSelectionPolicy::WEIGHTED_TAIL),
+                   MakeEnumAccessor (&LatencyAwareSelectionPolicy::m_objective),
+                   MakeEnumChecker (LatencyAwareSelectionPolicy::WEIGHTED_TAIL, "WeightedTail",
+                                    LatencyAwareSelectionPolicy::BOUNDED_DELAY, "BoundedDelay"))
+    .AddAttribute ("Percentile",
+                   "The percentile of the predicted delays considered as the tail delay.",
+                   DoubleValue (0.95),
+                   MakeDoubleAccessor (&LatencyAwareSelectionPolicy::m_percentile),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("TailWeight",
+                   "The weight of the tail delay (the weight of the mean delay is one minus "
+                   "this value) in the WeightedTail objective.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&LatencyAwareSelectionPolicy::m_tailWeight),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("DelayBound",
+                   "The bound on the tail delay in the BoundedDelay objective.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&LatencyAwareSelectionPolicy::m_delayBound),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+std::vector<Time>
+LatencyAwareSelectionPolicy::PredictDelays (const SuMuSnapshot& snapshot,
+                                            MultiUserScheduler::TxFormat format)
+{
+  std::vector<Time> delays;
+  delays.reserve (snapshot.candidates.size ());
+  Time elapsed;
+  std::size_t groupSize = std::max<std::size_t> (snapshot.muGroupSize, 1);
+
+  for (std::size_t i = 0; i < snapshot.candidates.size (); i++)
+    {
+      if (format == MultiUserScheduler::SU_TX)
+        {
+          elapsed += snapshot.accessTime + snapshot.candidates[i].suAirtime;
+        }
+      else if (i % groupSize == 0)
+        {
+          // a new group is served
+          elapsed += snapshot.accessTime + snapshot.muAirtime;
+        }
+      delays.push_back (snapshot.candidates[i].holDelay + elapsed);
+    }
+  return delays;
+}
+
+Time
+LatencyAwareSelectionPolicy::GetPercentile (std::vector<Time>& delays) const
+{
+  if (delays.empty ())
+    {
+      return Time ();
+    }
+  std::sort (delays.begin (), delays.end ());
+  // nearest-rank percentile
+  std::size_t rank = static_cast<std::size_t> (std::ceil (m_percentile * delays.size ()));
+  return delays[std::max<std::size_t> (rank, 1) - 1];
+}
+
+MultiUserScheduler::TxFormat
+LatencyAwareSelectionPolicy::Select (const SuMuSnapshot& snapshot)
+{
+  NS_LOG_FUNCTION (this);
+
+  MultiUserScheduler::TxFormat formats[2] = {MultiUserScheduler::SU_TX, MultiUserScheduler::DL_MU_TX};
+  double throughput[2] = {snapshot.suThroughput, snapshot.muThroughput};
+  Time mean[2];
+  Time tail[2];
+
+  for (std::size_t i = 0; i < 2; i++)
+    {
+      std::vector<Time> delays = PredictDelays (snapshot, formats[i]);
+      if (!delays.empty ())
+        {
+          Time sum;
+          for (const auto& delay : delays)
+            {
+              sum += delay;
+            }
+          mean[i] = sum / static_cast<int64_t> (delays.size ());
+        }
+      tail[i] = GetPercentile (delays);
+      NS_LOG_DEBUG ((i == 0 ? "SU" : "DL MU") << ": mean delay=" << mean[i].As (Time::US)
+                    << ", tail delay=" << tail[i].As (Time::US));
+    }
+
+  // index of the format with the highest throughput
+  std::size_t best = (throughput[0] > throughput[1] ? 0 : 1);
+
+  if (m_objective == WEIGHTED_TAIL)
+    {
+      double cost[2];
+      for (std::size_t i = 0; i < 2; i++)
+        {
+          cost[i] = (1 - m_tailWeight) * mean[i].GetNanoSeconds ()
+                    + m_tailWeight * tail[i].GetNanoSeconds ();
+        }
+      if (cost[1 - best] < cost[best])
+        {
+          best = 1 - best;
+        }
+    }
+  else if (tail[best] > m_delayBound
+           && (tail[1 - best] <= m_delayBound || tail[1 - best] < tail[best]))
+    {
+      // the format with the highest throughput does not meet the bound, while
+      // the other one does or at least gets closer to it
+      best = 1 - best;
+    }
+  return formats[best];
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (FixedSelectionPolicy);
+
+TypeId
+FixedSelectionPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FixedSelectionPolicy")
+    .SetParent<SuMuSelectionPolicy> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<FixedSelectionPolicy> ()
+    .AddAttribute ("Format",
+                   "The format that is always selected.",
+                   EnumValue (MultiUserScheduler::DL_MU_TX),
+                   MakeEnumAccessor (&FixedSelectionPolicy::m_format),
+                   MakeEnumChecker (MultiUserScheduler::SU_TX, "Su",
+                                    MultiUserScheduler::DL_MU_TX, "DlMu"))
+  ;
+  return tid;
+}
+
+MultiUserScheduler::TxFormat
+FixedSelectionPolicy::Select (const SuMuSnapshot& snapshot)
+{
+  NS_LOG_FUNCTION (this);
+  return m_format;
+}
+
+bool
+FixedSelectionPolicy::CanReuseDecision (void) const
+{
+  return true;
+}
+
+} //namespace ns3
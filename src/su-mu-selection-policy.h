@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SU_MU_SELECTION_POLICY_H
+#define SU_MU_SELECTION_POLICY_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/mac48-address.h"
+#include "multi-user-scheduler.h"
+#include <vector>
+
+namespace ns3 {
+
+class ApWifiMac;
+class HeFrameExchangeManager;
+
+/**
+ * \ingroup wifi
+ *
+ * Read-only view of the alternatives a Multi-User Scheduler is choosing
+ * between when it selects the format of a DL transmission.
+ */
+struct SuMuSnapshot
+{
+  /// A candidate station
+  struct Candidate
+  {
+    Mac48Address address;     //!< MAC address of the station
+    uint16_t aid;             //!< AID of the station
+    uint8_t tid;              //!< TID of the head-of-line MPDU
+    uint32_t mpduSize;        //!< size in bytes of the head-of-line MPDU
+    uint8_t mcs;              //!< HE MCS used to transmit to the station
+    uint16_t ampduLength;     //!< predicted A-MPDU length in a DL MU PPDU
+    Time holDelay;            //!< time spent in the queue by the head-of-line MPDU
+    Time suAirtime;           //!< airtime of an SU PPDU to the station
+  };
+
+  std::vector<Candidate> candidates;  //!< candidate stations, in order of priority
+  Time availableTime;                 //!< time available for the frame exchange (Time::Min () if unlimited)
+  uint32_t nQueuedPackets {0};        //!< packets queued by the AC that gained access
+  uint32_t queueCapacity {0};         //!< max packets the queue of the AC can hold
+  Time accessTime;                    //!< expected time to access the channel
+  Time suAirtime;                     //!< airtime of the SU PPDU to the first candidate
+  uint32_t suBytes {0};               //!< bytes sent in the SU PPDU
+  double suThroughput {0};            //!< predicted SU throughput (Mbps)
+  std::size_t muGroupSize {0};        //!< size of the DL MU group with the highest throughput
+  Time muAirtime;                     //!< airtime of the DL MU PPDU to that group
+  uint32_t muBytes {0};               //!< bytes sent in the DL MU PPDU
+  double muThroughput {0};            //!< predicted DL MU throughput (Mbps)
+  bool txopPlanned {false};           //!< whether the PPDUs of the TXOP have been planned
+  std::size_t plannedMuGroupSize {0}; //!< size of the DL MU group starting the plan (0 if SU)
+
+  /**
+   * TracedCallback signature for SU/MU selections.
+   *
+   * \param snapshot the alternatives
+   * \param format the selected format
+   */
+  typedef void (* TracedCallback)(const SuMuSnapshot& snapshot, MultiUserScheduler::TxFormat format);
+};
+
+/**
+ * \ingroup wifi
+ *
+ * SuMuSelectionPolicy is the abstract base class of the strategies a
+ * Multi-User Scheduler uses to select between an SU transmission to the
+ * first candidate station and a DL MU transmission to a group of candidates.
+ * The scheduler computes the alternatives and passes them to the policy as
+ * a snapshot, hence policies can be swapped via an attribute of the
+ * scheduler without modifying it.
+ */
+class SuMuSelectionPolicy : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SuMuSelectionPolicy ();
+  virtual ~SuMuSelectionPolicy ();
+
+  /**
+   * Select the format of the next DL transmission.
+   *
+   * \param snapshot the alternatives
+   * \return either SU_TX or DL_MU_TX
+   */
+  virtual MultiUserScheduler::TxFormat Select (const SuMuSnapshot& snapshot) = 0;
+
+  /**
+   * Notify the policy that it is being used by the scheduler of the given AP,
+   * so that it can connect to the traces it needs.
+   *
+   * \param apMac the MAC of the AP
+   * \param heFem the HE Frame Exchange Manager of the AP
+   */
+  virtual void Attach (Ptr<ApWifiMac> apMac, Ptr<HeFrameExchangeManager> heFem);
+
+  /**
+   * Notify the policy that it is no longer used by the scheduler.
+   */
+  virtual void Detach (void);
+
+  /**
+   * \return true if the scheduler can reuse the last decision as long as the
+   *         candidates and the queue have not changed materially
+   */
+  virtual bool CanReuseDecision (void) const;
+};
+
+
+/**
+ * \ingroup wifi
+ *
+ * Select the format with the highest predicted throughput or, if the PPDUs
+ * of the TXOP have been planned, the format of the first planned PPDU.
+ */
+class ThroughputSelectionPolicy : public SuMuSelectionPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MultiUserScheduler::TxFormat Select (const SuMuSnapshot& snapshot) override;
+  bool CanReuseDecision (void) const override;
+};
+
+
+/**
+ * \ingroup wifi
+ *
+ * Select SU when the fraction of the queue occupied by packets exceeds the
+ * Threshold attribute, so that the heaviest station is drained, and DL MU
+ * otherwise.
+ */
+class QueueOccupancySelectionPolicy : public SuMuSelectionPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MultiUserScheduler::TxFormat Select (const SuMuSnapshot& snapshot) override;
+
+private:
+  double m_threshold;  //!< queue occupancy above which SU is selected
+};
+
+
+/**
+ * \ingroup wifi
+ *
+ * Select the format with the highest predicted throughput, unless it takes
+ * longer than the Target attribute to serve all the candidates with that
+ * format while the other format does not. Serving all the candidates takes
+ * one SU PPDU per candidate with SU, and one DL MU PPDU per group with DL MU,
+ * each preceded by a channel access.
+ */
+class LatencyTargetSelectionPolicy : public SuMuSelectionPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MultiUserScheduler::TxFormat Select (const SuMuSnapshot& snapshot) override;
+
+private:
+  Time m_target;       //!< time within which all the candidates should be served
+};
+
+
+/**
+ * \ingroup wifi
+ *
+ * Select the format that minimizes an objective computed on the delay that
+ * the head-of-line MPDU of every candidate is predicted to experience.
+ *
+ * The predicted delay of a candidate is the time its head-of-line MPDU has
+ * already spent in the queue plus the time until the candidate is served,
+ * assuming that the candidates are served in order: with SU, one SU PPDU
+ * per candidate; with DL MU, one DL MU PPDU per group of candidates. Every
+ * PPDU is preceded by a channel access.
+ *
+ * With the WeightedTail objective, the selected format minimizes the mean
+ * delay and the delay percentile set by the Percentile attribute, weighted
+ * by the TailWeight attribute. With the BoundedDelay objective, the selected
+ * format is the one with the highest predicted throughput among those whose
+ * delay percentile does not exceed the DelayBound attribute or, if none
+ * does, the one with the lowest delay percentile.
+ */
+class LatencyAwareSelectionPolicy : public SuMuSelectionPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * The objective minimized by the policy
+   */
+  enum Objective
+  {
+    WEIGHTED_TAIL = 0,   //!< weighted sum of the mean and tail delay
+    BOUNDED_DELAY        //!< highest throughput subject to a bound on the tail delay
+  };
+
+  MultiUserScheduler::TxFormat Select (const SuMuSnapshot& snapshot) override;
+
+  /**
+   * Predict the delay of the head-of-line MPDU of every candidate.
+   *
+   * \param snapshot the alternatives
+   * \param format either SU_TX or DL_MU_TX
+   * \return the predicted delay of every candidate, in the order of the candidates
+   */
+  static std::vector<Time> PredictDelays (const SuMuSnapshot& snapshot,
+                                          MultiUserScheduler::TxFormat format);
+
+private:
+  /**
+   * \param delays the predicted delays (sorted in place)
+   * \return the delay percentile set by the Percentile attribute
+   */
+  Time GetPercentile (std::vector<Time>& delays) const;
+
+  Objective m_objective;   //!< the objective to minimize
+  double m_percentile;     //!< the percentile of the delay considered as the tail
+  double m_tailWeight;     //!< weight of the tail delay in the WeightedTail objective
+  Time m_delayBound;       //!< bound on the tail delay in the BoundedDelay objective
+};
+
+
+/**
+ * \ingroup wifi
+ *
+ * Always select the format set by the Format attribute.
+ */
+class FixedSelectionPolicy : public SuMuSelectionPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MultiUserScheduler::TxFormat Select (const SuMuSnapshot& snapshot) override;
+  bool CanReuseDecision (void) const override;
+
+private:
+  MultiUserScheduler::TxFormat m_format;  //!< the selected format
+};
+
+} //namespace ns3
+
+#endif /* SU_MU_SELECTION_POLICY_H */
@@ -0,0 +1,378 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
+#include "sumu-cost-model.h"
+#include "wifi-phy.h"
+#include "wifi-utils.h"
+#include "he-phy.h"
+#include "mpdu-aggregator.h"
+#include "ctrl-headers.h"
+#include <list>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SuMuCostModel");
+
+NS_OBJECT_ENSURE_REGISTERED (SuMuCostModel);
+
+TypeId
+SuMuCostModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SuMuCostModel")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<SuMuCostModel> ()
+    .AddAttribute ("MpduSizeQuantum",
+                   "MPDU sizes are rounded up to a multiple of this value before "
+                   "selecting a data table. The default value matches the padding of "
+                   "A-MPDU subframes, hence it does not introduce any approximation.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&SuMuCostModel::m_mpduSizeQuantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxDataTables",
+                   "The maximum number of data tables (one per quantized MPDU size) "
+                   "kept at the same time. When a new table is needed, the least "
+                   "recently used one is discarded.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&SuMuCostModel::m_maxDataTables),
+                   MakeUintegerChecker<uint16_t> (1))
+  ;
+  return tid;
+}
+
+SuMuCostModel::SuMuCostModel ()
+  : m_channelWidth (0),
+    m_band (WIFI_PHY_BAND_UNSPECIFIED),
+    m_guardInterval (0),
+    m_maxAmpduLength (0),
+    m_maxUsers (0),
+    m_maxNss (0),
+    m_dataTable (nullptr)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SuMuCostModel::~SuMuCostModel ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SuMuCostModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_phy = 0;
+  m_ackTable.clear ();
+  m_muReferenceTable.clear ();
+  m_dataTables.clear ();
+  m_dataTableIndex.clear ();
+  m_dataTable = nullptr;
+  Object::DoDispose ();
+}
+
+void
+SuMuCostModel::Configure (Ptr<WifiPhy> phy, const WifiTxVector& ctrlTxVector, uint16_t maxAmpduLength,
+                          uint16_t guardInterval)
+{
+  NS_LOG_FUNCTION (this << phy << ctrlTxVector << maxAmpduLength << guardInterval);
+  NS_ASSERT (phy != 0 && maxAmpduLength > 0);
+  NS_ABORT_MSG_IF (guardInterval != 800 && guardInterval != 1600 && guardInterval != 3200,
+                   "Invalid HE guard interval: " << guardInterval);
+
+  m_phy = phy;
+  m_channelWidth = phy->GetChannelWidth ();
+  m_band = phy->GetPhyBand ();
+  m_guardInterval = guardInterval;
+  m_maxAmpduLength = maxAmpduLength;
+  m_maxUsers = HeRu::GetNRus (m_channelWidth, HeRu::RU_26_TONE);
+  m_maxNss = phy->GetMaxSupportedTxSpatialStreams ();
+  m_dataTables.clear ();
+  m_dataTableIndex.clear ();
+  m_dataTable = nullptr;
+
+  Time sifs = phy->GetSifs ();
+  Time baDuration = WifiPhy::CalculateTxDuration (GetBlockAckSize (BlockAckType::COMPRESSED),
+                                                  ctrlTxVector, m_band);
+  m_suAckDuration = sifs + baDuration;
+  Time barDuration = WifiPhy::CalculateTxDuration (GetBlockAckRequestSize (BlockAckReqType::COMPRESSED),
+                                                   ctrlTxVector, m_band);
+  // duration of an MU-BAR Trigger Frame soliciting n = 1, ..., m_maxUsers stations
+  std::vector<Time> muBarDuration (m_maxUsers + 1);
+  std::list<BlockAckReqType> barTypes;
+  for (std::size_t n = 1; n <= m_maxUsers; n++)
+    {
+      barTypes.push_back (BlockAckReqType::COMPRESSED);
+      muBarDuration[n] = WifiPhy::CalculateTxDuration (GetMuBarSize (barTypes), ctrlTxVector, m_band);
+    }
+
+  uint32_t aggrMuBarSize = GetMuBarSize ({BlockAckReqType::COMPRESSED});
+
+  WifiTxVector tbTxVector;
+  tbTxVector.SetPreambleType (WIFI_PREAMBLE_HE_TB);
+  tbTxVector.SetChannelWidth (m_channelWidth);
+  tbTxVector.SetGuardInterval (CtrlTriggerHeader ().GetGuardInterval ());
+
+  m_ackTable.assign (N_ACK_METHODS * m_maxNss * N_MCS * N_RU_TYPES * (m_maxUsers + 1), Time ());
+  m_muReferenceTable.assign (N_MCS * N_RU_TYPES * (m_maxUsers + 1), Time ());
+
+  for (uint8_t ru = 0; ru < N_RU_TYPES; ru++)
+    {
+      HeRu::RuType ruType = static_cast<HeRu::RuType> (ru);
+      std::size_t nRus = HeRu::GetNRus (m_channelWidth, ruType);
+      if (nRus == 0)
+        {
+          continue;
+        }
+      HeRu::RuSpec ruSpec = HeRu::GetRusOfType (m_channelWidth, ruType).front ();
+
+      for (uint8_t nss = 1; nss <= m_maxNss; nss++)
+        {
+          for (uint8_t mcs = 0; mcs < N_MCS; mcs++)
+            {
+              tbTxVector.SetHeMuUserInfo (1, {ruSpec, HePhy::GetHeMcs (mcs), nss});
+              Time tbBaDuration = WifiPhy::CalculateTxDuration (GetBlockAckSize (BlockAckType::COMPRESSED),
+                                                                tbTxVector, m_band, 1);
+              // time to transmit an MU-BAR (soliciting the receiver only) aggregated to
+              // a PSDU sent over an RU of this type (at the shortest guard interval)
+              Time aggrMuBarDuration = Seconds (8.0 * MpduAggregator::GetSizeIfAggregated (aggrMuBarSize, 0)
+                                                / HePhy::GetDataRate (mcs, HeRu::GetBandwidth (ruType), 800, nss));
+
+              for (std::size_t n = 1; n <= nRus; n++)
+                {
+                  std::size_t base = (((nss - 1) * N_MCS + mcs) * N_RU_TYPES + ru) * (m_maxUsers + 1) + n;
+                  std::size_t stride = m_maxNss * N_MCS * N_RU_TYPES * (m_maxUsers + 1);
+                  // BLOCK_ACK: the (only) receiver responds with a BlockAck
+                  m_ackTable[0 * stride + base] = sifs + baDuration;
+                  // DL_MU_BAR_BA_SEQUENCE: the first receiver responds immediately,
+                  // the others are solicited by a BlockAckReq each
+                  m_ackTable[1 * stride + base] = sifs + baDuration
+                                                  + (sifs + barDuration + sifs + baDuration) * (n - 1);
+                  // DL_MU_TF_MU_BAR: an MU-BAR solicits BlockAcks in TB PPDUs
+                  m_ackTable[2 * stride + base] = sifs + muBarDuration[n] + sifs + tbBaDuration;
+                  // DL_MU_AGGREGATE_TF: the MU-BAR is aggregated to the data PSDUs,
+                  // which therefore last longer
+                  m_ackTable[3 * stride + base] = sifs + tbBaDuration + aggrMuBarDuration;
+                }
+            }
+        }
+    }
+  NS_LOG_DEBUG ("Ack table built for a " << m_channelWidth << " MHz channel");
+}
+
+bool
+SuMuCostModel::IsConfigured (uint16_t channelWidth, uint16_t maxAmpduLength, uint16_t guardInterval) const
+{
+  return m_phy != 0 && m_channelWidth == channelWidth && m_maxAmpduLength == maxAmpduLength
+         && m_guardInterval == guardInterval;
+}
+
+uint16_t
+SuMuCostModel::GetMaxAmpduLength (void) const
+{
+  return m_maxAmpduLength;
+}
+
+void
+SuMuCostModel::SetMpduSize (uint32_t mpduSize)
+{
+  NS_ASSERT_MSG (m_phy != 0, "The cost model has not been configured");
+
+  uint32_t key = ((mpduSize + m_mpduSizeQuantum - 1) / m_mpduSizeQuantum) * m_mpduSizeQuantum;
+  auto it = m_dataTableIndex.find (key);
+
+  if (it != m_dataTableIndex.end ())
+    {
+      // move the table to the front of the LRU list
+      m_dataTables.splice (m_dataTables.begin (), m_dataTables, it->second);
+      m_dataTable = &m_dataTables.front ();
+      return;
+    }
+
+  if (m_dataTables.size () >= m_maxDataTables)
+    {
+      NS_LOG_DEBUG ("Discarding the data table for MPDU size " << m_dataTables.back ().mpduSize);
+      m_dataTableIndex.erase (m_dataTables.back ().mpduSize);
+      m_dataTables.pop_back ();
+    }
+
+  // A-MPDU subframes other than the last one are padded to a multiple of 4
+  // bytes, hence all the subframes but the first one add the same size
+  uint32_t firstSubframeSize = MpduAggregator::GetSizeIfAggregated (key, 0);
+  m_dataTables.push_front ({key, firstSubframeSize,
+                            MpduAggregator::GetSizeIfAggregated (key, firstSubframeSize) - firstSubframeSize,
+                            std::vector<Time> (m_maxNss * N_MCS * N_PPDU_TYPES * m_maxAmpduLength, Time ())});
+  m_dataTableIndex[key] = m_dataTables.begin ();
+  m_dataTable = &m_dataTables.front ();
+}
+
+Time
+SuMuCostModel::LookupDataDuration (uint8_t mcs, uint8_t nss, uint8_t ppduType, uint16_t ampduLength) const
+{
+  NS_ASSERT_MSG (m_dataTable != nullptr, "No MPDU size has been selected");
+  NS_ASSERT (mcs < N_MCS && ampduLength > 0);
+  NS_ASSERT_MSG (nss >= 1 && nss <= m_maxNss, "Invalid number of spatial streams: " << +nss);
+
+  uint16_t len = std::min (ampduLength, m_maxAmpduLength);
+  Time& duration = m_dataTable->durations[(((nss - 1) * N_MCS + mcs) * N_PPDU_TYPES + ppduType)
+                                          * m_maxAmpduLength + len - 1];
+
+  if (!duration.IsZero ())
+    {
+      return duration;
+    }
+
+  uint32_t ampduSize = m_dataTable->firstSubframeSize + (len - 1) * m_dataTable->nextSubframeSize;
+  WifiTxVector txVector;
+  txVector.SetChannelWidth (m_channelWidth);
+  txVector.SetGuardInterval (m_guardInterval);
+
+  if (ppduType == HE_SU)
+    {
+      // HE SU PPDU occupying the whole channel
+      txVector.SetPreambleType (WIFI_PREAMBLE_HE_SU);
+      txVector.SetMode (HePhy::GetHeMcs (mcs));
+      txVector.SetNss (nss);
+      duration = WifiPhy::CalculateTxDuration (ampduSize, txVector, m_band);
+    }
+  else
+    {
+      // all the RUs of the given type are allocated; the HE-SIG-B duration is
+      // corrected for the actual number of users by GetDataDuration
+      HeRu::RuType ruType = static_cast<HeRu::RuType> (ppduType);
+      txVector.SetPreambleType (WIFI_PREAMBLE_HE_MU);
+      uint16_t staId = 1;
+      for (const auto& ru : HeRu::GetRusOfType (m_channelWidth, ruType))
+        {
+          txVector.SetHeMuUserInfo (staId++, {ru, HePhy::GetHeMcs (mcs), nss});
+        }
+      duration = WifiPhy::CalculateTxDuration (ampduSize, txVector, m_band, 1);
+    }
+  return duration;
+}
+
+Time
+SuMuCostModel::LookupMuReferenceDuration (uint8_t mcs, HeRu::RuType ruType, std::size_t nUsers) const
+{
+  NS_ASSERT (mcs < N_MCS && nUsers > 0 && nUsers <= HeRu::GetNRus (m_channelWidth, ruType));
+
+  Time& duration = m_muReferenceTable[(mcs * N_RU_TYPES + static_cast<std::size_t> (ruType))
+                                      * (m_maxUsers + 1) + nUsers];
+  if (!duration.IsZero ())
+    {
+      return duration;
+    }
+
+  // every user is sent a one-byte PSDU, so that the PPDUs carry one data symbol
+  // regardless of the number of users
+  WifiTxVector txVector;
+  txVector.SetChannelWidth (m_channelWidth);
+  txVector.SetGuardInterval (m_guardInterval);
+  txVector.SetPreambleType (WIFI_PREAMBLE_HE_MU);
+  const std::vector<HeRu::RuSpec>& rus = HeRu::GetRusOfType (m_channelWidth, ruType);
+  for (std::size_t i = 0; i < nUsers; i++)
+    {
+      txVector.SetHeMuUserInfo (i + 1, {rus[i], HePhy::GetHeMcs (mcs), 1});
+    }
+  duration = WifiPhy::CalculateTxDuration (1, txVector, m_band, 1);
+  return duration;
+}
+
+Time
+SuMuCostModel::GetDataDuration (uint8_t mcs, uint8_t nss, HeRu::RuType ruType, std::size_t nUsers,
+                                uint16_t ampduLength, uint16_t guardInterval) const
+{
+  NS_ASSERT_MSG (guardInterval == m_guardInterval, "The cost model has been configured for a "
+                 << m_guardInterval << " ns guard interval");
+  std::size_t nRus = HeRu::GetNRus (m_channelWidth, ruType);
+  NS_ASSERT (nRus > 0 && nUsers > 0);
+
+  Time duration = LookupDataDuration (mcs, nss, static_cast<uint8_t> (ruType), ampduLength);
+  std::size_t n = std::min (nUsers, nRus);
+  if (n < nRus)
+    {
+      // the table entry assumes that all the RUs of the given type are allocated
+      duration += LookupMuReferenceDuration (mcs, ruType, n) - LookupMuReferenceDuration (mcs, ruType, nRus);
+    }
+  return duration;
+}
+
+Time
+SuMuCostModel::GetSuDataDuration (uint8_t mcs, uint8_t nss, uint16_t ampduLength, uint16_t guardInterval) const
+{
+  NS_ASSERT_MSG (guardInterval == m_guardInterval, "The cost model has been configured for a "
+                 << m_guardInterval << " ns guard interval");
+  return LookupDataDuration (mcs, nss, HE_SU, ampduLength);
+}
+
+Time
+SuMuCostModel::GetSuAckDuration (void) const
+{
+  NS_ASSERT_MSG (m_phy != 0, "The cost model has not been configured");
+  return m_suAckDuration;
+}
+
+Time
+SuMuCostModel::GetSuAirtime (uint8_t mcs, uint8_t nss, uint16_t ampduLength, uint16_t guardInterval) const
+{
+  return GetSuDataDuration (mcs, nss, ampduLength, guardInterval) + GetSuAckDuration ();
+}
+
+Time
+SuMuCostModel::GetAckDuration (WifiAcknowledgment::Method method, uint8_t mcs, uint8_t nss,
+                               HeRu::RuType ruType, std::size_t nUsers) const
+{
+  NS_ASSERT_MSG (m_phy != 0, "The cost model has not been configured");
+  NS_ASSERT (mcs < N_MCS && nUsers > 0);
+  NS_ASSERT_MSG (nss >= 1 && nss <= m_maxNss, "Invalid number of spatial streams: " << +nss);
+
+  std::size_t methodIndex;
+  switch (method)
+    {
+    case WifiAcknowledgment::BLOCK_ACK:
+      methodIndex = 0;
+      break;
+    case WifiAcknowledgment::DL_MU_BAR_BA_SEQUENCE:
+      methodIndex = 1;
+      break;
+    case WifiAcknowledgment::DL_MU_TF_MU_BAR:
+      methodIndex = 2;
+      break;
+    case WifiAcknowledgment::DL_MU_AGGREGATE_TF:
+      methodIndex = 3;
+      break;
+    default:
+      NS_ABORT_MSG ("Unsupported acknowledgment method: " << method);
+    }
+
+  std::size_t n = std::min (nUsers, HeRu::GetNRus (m_channelWidth, ruType));
+  NS_ASSERT (n > 0);
+  return m_ackTable[(((methodIndex * m_maxNss + nss - 1) * N_MCS + mcs) * N_RU_TYPES
+                     + static_cast<std::size_t> (ruType)) * (m_maxUsers + 1) + n];
+}
+
+Time
+SuMuCostModel::GetAirtime (uint8_t mcs, uint8_t nss, HeRu::RuType ruType, uint16_t ampduLength,
+                           WifiAcknowledgment::Method method, uint16_t guardInterval) const
+{
+  std::size_t nRus = HeRu::GetNRus (m_channelWidth, ruType);
+  return GetDataDuration (mcs, nss, ruType, nRus, ampduLength, guardInterval)
+         + GetAckDuration (method, mcs, nss, ruType, nRus);
+}
+
+} //namespace ns3
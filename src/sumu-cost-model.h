@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SUMU_COST_MODEL_H
+#define SUMU_COST_MODEL_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/wifi-phy-band.h"
+#include "ns3/wifi-tx-vector.h"
+#include "ns3/wifi-acknowledgment.h"
+#include "he-ru.h"
+#include <list>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class WifiPhy;
+
+/**
+ * \ingroup wifi
+ *
+ * SuMuCostModel precomputes the airtime of the DL frame exchanges an HE AP
+ * can perform, so that the SU-vs-MU decision of a Multi-User Scheduler is a
+ * set of table lookups rather than a sequence of PHY duration computations.
+ *
+ * Two tables are kept. The data table stores, for every number of spatial
+ * streams, HE MCS, RU type and A-MPDU length, the duration of an HE MU PPDU
+ * whose users are all allocated an RU of the given type, as well as the
+ * duration of an HE SU PPDU occupying the whole channel, at the guard interval
+ * the model has been configured for. The duration of an HE MU PPDU serving
+ * fewer users is obtained by correcting the HE-SIG-B duration, which is
+ * computed once per RU type, HE MCS and number of users.
+ * The data table depends on the size of the aggregated MPDUs, hence one table
+ * is kept per (quantized) MPDU size; the least recently used table is discarded
+ * when too many tables are kept. The entries of a data table are computed the
+ * first time they are looked up, so that only the A-MPDU lengths actually
+ * considered by the scheduler cost a PHY duration computation. The
+ * acknowledgment table stores, for every acknowledgment sequence, number of
+ * spatial streams, HE MCS, RU type and number of receivers, the time from the
+ * end of the data PPDU to the end of the acknowledgment sequence (including
+ * SIFS). Numbers of spatial streams range up to the maximum supported by the
+ * PHY of the AP.
+ *
+ * The acknowledgment table is built when Configure is called, i.e., when the
+ * channel width and the HE configuration are known, and needs to be rebuilt
+ * only when they change.
+ */
+class SuMuCostModel : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SuMuCostModel ();
+  virtual ~SuMuCostModel ();
+
+  /**
+   * Build the acknowledgment table and discard all the data tables.
+   *
+   * \param phy the PHY of the AP
+   * \param ctrlTxVector the TXVECTOR used to transmit control frames (BAR, BA, MU-BAR)
+   * \param maxAmpduLength the maximum number of MPDUs in an A-MPDU
+   * \param guardInterval the guard interval (in nanoseconds) of the data PPDUs
+   */
+  void Configure (Ptr<WifiPhy> phy, const WifiTxVector& ctrlTxVector, uint16_t maxAmpduLength,
+                  uint16_t guardInterval);
+
+  /**
+   * \param channelWidth the current channel width
+   * \param maxAmpduLength the current maximum number of MPDUs in an A-MPDU
+   * \param guardInterval the current guard interval in nanoseconds
+   * \return true if the tables have been built for the given parameters
+   */
+  bool IsConfigured (uint16_t channelWidth, uint16_t maxAmpduLength, uint16_t guardInterval) const;
+
+  /**
+   * Select the data table for the given MPDU size, creating an empty table
+   * (and discarding the least recently used one, if needed) if it does not exist.
+   *
+   * \param mpduSize the size in bytes of the MPDUs to aggregate
+   */
+  void SetMpduSize (uint32_t mpduSize);
+
+  /**
+   * \return the maximum number of MPDUs in an A-MPDU covered by the tables
+   */
+  uint16_t GetMaxAmpduLength (void) const;
+
+  /**
+   * Get the duration of an HE MU PPDU serving the given number of users and
+   * carrying an A-MPDU of the given length (and of the MPDU size selected via
+   * SetMpduSize) to each user.
+   *
+   * \param mcs the HE MCS index
+   * \param nss the number of spatial streams
+   * \param ruType the RU type allocated to every user
+   * \param nUsers the number of users of the HE MU PPDU (clamped to the number of RUs of the given type)
+   * \param ampduLength the number of MPDUs in the A-MPDU (clamped to the table size)
+   * \param guardInterval the guard interval in nanoseconds (must be the configured one)
+   * \return the PPDU duration
+   */
+  Time GetDataDuration (uint8_t mcs, uint8_t nss, HeRu::RuType ruType, std::size_t nUsers,
+                        uint16_t ampduLength, uint16_t guardInterval) const;
+
+  /**
+   * Get the duration of an HE SU PPDU occupying the whole channel and carrying
+   * an A-MPDU of the given length (and of the MPDU size selected via SetMpduSize).
+   *
+   * \param mcs the HE MCS index
+   * \param nss the number of spatial streams
+   * \param ampduLength the number of MPDUs in the A-MPDU (clamped to the table size)
+   * \param guardInterval the guard interval in nanoseconds (must be the configured one)
+   * \return the PPDU duration
+   */
+  Time GetSuDataDuration (uint8_t mcs, uint8_t nss, uint16_t ampduLength, uint16_t guardInterval) const;
+
+  /**
+   * \return the time from the end of an HE SU PPDU to the end of the BlockAck
+   *         sent in response (including SIFS)
+   */
+  Time GetSuAckDuration (void) const;
+
+  /**
+   * Get the airtime of a frame exchange in which an HE SU PPDU occupying the
+   * whole channel carries an A-MPDU of the given length and is acknowledged
+   * by a BlockAck.
+   *
+   * \param mcs the HE MCS index
+   * \param nss the number of spatial streams
+   * \param ampduLength the number of MPDUs in the A-MPDU
+   * \param guardInterval the guard interval in nanoseconds
+   * \return the duration of the data PPDU plus the BlockAck
+   */
+  Time GetSuAirtime (uint8_t mcs, uint8_t nss, uint16_t ampduLength, uint16_t guardInterval) const;
+
+  /**
+   * Get the time taken by the given acknowledgment sequence, from the end of
+   * the data PPDU to the end of the last response frame.
+   *
+   * \param method the acknowledgment method (BLOCK_ACK or a DL MU method)
+   * \param mcs the HE MCS index used by the receivers of the data PPDU
+   * \param nss the number of spatial streams used by the receivers of the data PPDU
+   * \param ruType the RU type allocated to the receivers
+   * \param nUsers the number of receivers of the data PPDU
+   * \return the duration of the acknowledgment sequence
+   */
+  Time GetAckDuration (WifiAcknowledgment::Method method, uint8_t mcs, uint8_t nss,
+                       HeRu::RuType ruType, std::size_t nUsers) const;
+
+  /**
+   * Get the airtime of a frame exchange in which every one of the receivers
+   * allocated an RU of the given type is sent an A-MPDU of the given length.
+   *
+   * \param mcs the HE MCS index
+   * \param nss the number of spatial streams
+   * \param ruType the RU type allocated to every user
+   * \param ampduLength the number of MPDUs in the A-MPDU
+   * \param method the acknowledgment method
+   * \param guardInterval the guard interval in nanoseconds
+   * \return the duration of the data PPDU plus the acknowledgment sequence
+   */
+  Time GetAirtime (uint8_t mcs, uint8_t nss, HeRu::RuType ruType, uint16_t ampduLength,
+                   WifiAcknowledgment::Method method, uint16_t guardInterval) const;
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  /// Data table of a (quantized) MPDU size
+  struct DataTable
+  {
+    uint32_t mpduSize;             //!< the size of the aggregated MPDUs
+    uint32_t firstSubframeSize;    //!< size of the first A-MPDU subframe
+    uint32_t nextSubframeSize;     //!< size of the following (padded) A-MPDU subframes
+    std::vector<Time> durations;   //!< PPDU durations indexed by NSS, MCS, PPDU type and A-MPDU length (zero if not computed yet)
+  };
+
+  /// Data tables, the most recently used first
+  typedef std::list<DataTable> DataTableList;
+
+  /**
+   * Get the duration of a PPDU from the selected data table, computing it if
+   * it is not in the table yet.
+   *
+   * \param mcs the HE MCS index
+   * \param nss the number of spatial streams
+   * \param ppduType the PPDU type (RU type or HE_SU)
+   * \param ampduLength the number of MPDUs in the A-MPDU (clamped to the table size)
+   * \return the PPDU duration
+   */
+  Time LookupDataDuration (uint8_t mcs, uint8_t nss, uint8_t ppduType, uint16_t ampduLength) const;
+
+  /**
+   * Get the duration of a minimal HE MU PPDU in which the first nUsers RUs of
+   * the given type are allocated, computing it if it is not in the table yet.
+   * Only the HE-SIG-B field depends on the number of users, hence the
+   * difference between two such durations is the HE-SIG-B correction.
+   *
+   * \param mcs the HE MCS index
+   * \param ruType the RU type
+   * \param nUsers the number of users (not greater than the number of RUs of the given type)
+   * \return the PPDU duration
+   */
+  Time LookupMuReferenceDuration (uint8_t mcs, HeRu::RuType ruType, std::size_t nUsers) const;
+
+  static const uint8_t N_MCS = 12;       //!< number of HE MCSs
+  static const uint8_t N_RU_TYPES = 7;   //!< number of HE RU types
+  static const uint8_t HE_SU = N_RU_TYPES; //!< index of HE SU PPDUs in the data table
+  static const uint8_t N_PPDU_TYPES = N_RU_TYPES + 1; //!< number of PPDU types in the data table
+  static const uint8_t N_ACK_METHODS = 4; //!< number of supported ack methods
+
+  Ptr<WifiPhy> m_phy;                    //!< the PHY of the AP
+  uint16_t m_channelWidth;               //!< the channel width tables refer to
+  WifiPhyBand m_band;                    //!< the band tables refer to
+  uint16_t m_guardInterval;              //!< the guard interval data tables refer to
+  uint16_t m_maxAmpduLength;             //!< max number of MPDUs in an A-MPDU
+  uint16_t m_maxUsers;                   //!< max number of users in a DL MU PPDU
+  uint8_t m_maxNss;                      //!< max number of spatial streams the tables cover
+  uint32_t m_mpduSizeQuantum;            //!< MPDU sizes are rounded up to a multiple of this value
+  uint16_t m_maxDataTables;              //!< max number of data tables kept at the same time
+  std::vector<Time> m_ackTable;          //!< duration of ack sequences
+  mutable std::vector<Time> m_muReferenceTable; //!< duration of minimal HE MU PPDUs (zero if not computed yet)
+  Time m_suAckDuration;                  //!< duration of the BlockAck following an HE SU PPDU
+  DataTableList m_dataTables;            //!< data tables, in LRU order
+  std::map<uint32_t, DataTableList::iterator> m_dataTableIndex; //!< data tables indexed by quantized MPDU size
+  DataTable* m_dataTable;                //!< the data table currently selected
+};
+
+} //namespace ns3
+
+#endif /* SUMU_COST_MODEL_H */
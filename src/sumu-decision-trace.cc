@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
+#include "sumu-decision-trace.h"
+#include <type_traits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SuMuDecisionTrace");
+
+static_assert (std::is_trivially_copyable<SuMuDecisionRecord>::value,
+               "SuMuDecisionRecord must be trivially copyable");
+
+NS_OBJECT_ENSURE_REGISTERED (SuMuDecisionRing);
+
+TypeId
+SuMuDecisionRing::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SuMuDecisionRing")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<SuMuDecisionRing> ()
+    .AddAttribute ("Capacity",
+                   "The maximum number of records stored in the ring buffer "
+                   "(rounded up to a power of two).",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&SuMuDecisionRing::SetCapacity,
+                                         &SuMuDecisionRing::GetCapacity),
+                   MakeUintegerChecker<uint32_t> (1, 1 << 24))
+  ;
+  return tid;
+}
+
+SuMuDecisionRing::SuMuDecisionRing ()
+  : m_mask (0),
+    m_head (0),
+    m_tail (0),
+    m_nDropped (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SuMuDecisionRing::~SuMuDecisionRing ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SuMuDecisionRing::SetCapacity (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+
+  uint64_t size = 1;
+  while (size < capacity)
+    {
+      size <<= 1;
+    }
+  m_buffer.assign (size, SuMuDecisionRecord ());
+  m_mask = size - 1;
+  m_head.store (0);
+  m_tail.store (0);
+}
+
+uint32_t
+SuMuDecisionRing::GetCapacity (void) const
+{
+  return m_buffer.size ();
+}
+
+void
+SuMuDecisionRing::Push (const SuMuDecisionRecord& record)
+{
+  uint64_t head = m_head.load (std::memory_order_relaxed);
+
+  if (head - m_tail.load (std::memory_order_acquire) == m_buffer.size ())
+    {
+      m_nDropped.fetch_add (1, std::memory_order_relaxed);
+      return;
+    }
+  m_buffer[head & m_mask] = record;
+  m_head.store (head + 1, std::memory_order_release);
+}
+
+bool
+SuMuDecisionRing::Pop (SuMuDecisionRecord& record)
+{
+  uint64_t tail = m_tail.load (std::memory_order_relaxed);
+
+  if (tail == m_head.load (std::memory_order_acquire))
+    {
+      return false;
+    }
+  record = m_buffer[tail & m_mask];
+  m_tail.store (tail + 1, std::memory_order_release);
+  return true;
+}
+
+uint32_t
+SuMuDecisionRing::GetSize (void) const
+{
+  return m_head.load (std::memory_order_acquire) - m_tail.load (std::memory_order_acquire);
+}
+
+uint64_t
+SuMuDecisionRing::GetNDropped (void) const
+{
+  return m_nDropped.load (std::memory_order_relaxed);
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (SuMuDecisionFileSink);
+
+TypeId
+SuMuDecisionFileSink::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SuMuDecisionFileSink")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<SuMuDecisionFileSink> ()
+  ;
+  return tid;
+}
+
+SuMuDecisionFileSink::SuMuDecisionFileSink ()
+  : m_nRecords (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SuMuDecisionFileSink::~SuMuDecisionFileSink ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SuMuDecisionFileSink::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+SuMuDecisionFileSink::Open (const std::string& filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Close ();
+  m_file.open (filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_IF (!m_file.is_open (), "Cannot open file " << filename);
+
+  uint16_t version = VERSION;
+  uint16_t recordSize = sizeof (SuMuDecisionRecord);
+  m_file.write ("SMDT", 4);
+  m_file.write (reinterpret_cast<const char*> (&version), sizeof (version));
+  m_file.write (reinterpret_cast<const char*> (&recordSize), sizeof (recordSize));
+  m_nRecords = 0;
+}
+
+void
+SuMuDecisionFileSink::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+}
+
+void
+SuMuDecisionFileSink::Write (const SuMuDecisionRecord& record)
+{
+  NS_ASSERT (m_file.is_open ());
+  m_file.write (reinterpret_cast<const char*> (&record), sizeof (record));
+  m_nRecords++;
+}
+
+uint64_t
+SuMuDecisionFileSink::GetNRecords (void) const
+{
+  return m_nRecords;
+}
+
+} //namespace ns3
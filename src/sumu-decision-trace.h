@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SUMU_DECISION_TRACE_H
+#define SUMU_DECISION_TRACE_H
+
+#include "ns3/object.h"
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * Record describing an SU/MU decision taken by a scheduler. The record is a
+ * plain struct, so that it can be copied into a ring buffer or written to a
+ * file as is. Fields are ordered by decreasing alignment and the record is
+ * explicitly padded, so that no uninitialized padding byte is written.
+ */
+struct SuMuDecisionRecord
+{
+  int64_t timeNs {0};           //!< time of the decision (ns)
+  int64_t suDurationNs {0};     //!< predicted duration of the SU frame exchange (ns)
+  int64_t muDurationNs {0};     //!< predicted duration of the DL MU frame exchange (ns)
+  double suThroughput {0.0};    //!< predicted SU throughput (Mbps)
+  double muThroughput {0.0};    //!< predicted DL MU throughput (Mbps)
+  uint32_t nQueuedPackets {0};  //!< packets queued by the AC that gained access
+  uint16_t nCandidates {0};     //!< number of candidate stations
+  uint16_t suAmpduLength {0};   //!< number of MPDUs in the estimated SU A-MPDU
+  uint16_t muGroupSize {0};     //!< number of candidate stations served by the DL MU alternative
+  uint8_t format {0};           //!< selected TX format (a MultiUserScheduler::TxFormat)
+  uint8_t reused {0};           //!< whether the last decision has been reused
+  uint8_t suReceiver[6] {};     //!< MAC address of the receiver of the SU alternative
+  uint8_t reserved[6] {};       //!< explicit padding, always zero
+
+  /**
+   * TracedCallback signature for SU/MU decisions.
+   *
+   * \param record the decision record
+   */
+  typedef void (* TracedCallback)(const SuMuDecisionRecord& record);
+};
+
+static_assert (sizeof (SuMuDecisionRecord) == 64, "SuMuDecisionRecord must not have implicit padding");
+
+/**
+ * \ingroup wifi
+ *
+ * SuMuDecisionRing stores the most recent SU/MU decision records in a
+ * fixed-size ring buffer. The ring buffer is lock-free for a single producer
+ * (the scheduler trace source) and a single consumer, which may run in a
+ * different thread. Records pushed when the ring buffer is full are dropped.
+ */
+class SuMuDecisionRing : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SuMuDecisionRing ();
+  virtual ~SuMuDecisionRing ();
+
+  /**
+   * Set the capacity of the ring buffer, which is rounded up to a power of two.
+   * The ring buffer is emptied, hence this function must not be called while
+   * records are being pushed or popped.
+   *
+   * \param capacity the capacity of the ring buffer (in records)
+   */
+  void SetCapacity (uint32_t capacity);
+  /**
+   * \return the capacity of the ring buffer (in records)
+   */
+  uint32_t GetCapacity (void) const;
+
+  /**
+   * Append a record to the ring buffer, unless the ring buffer is full. Can be
+   * connected to the SuMuDecision trace source of a scheduler.
+   *
+   * \param record the decision record
+   */
+  void Push (const SuMuDecisionRecord& record);
+  /**
+   * Remove the oldest record from the ring buffer.
+   *
+   * \param record the record to fill
+   * \return false if the ring buffer is empty
+   */
+  bool Pop (SuMuDecisionRecord& record);
+
+  /**
+   * \return the number of records in the ring buffer
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \return the number of records dropped because the ring buffer was full
+   */
+  uint64_t GetNDropped (void) const;
+
+private:
+  std::vector<SuMuDecisionRecord> m_buffer;  //!< the records
+  uint64_t m_mask;                           //!< capacity minus one
+  std::atomic<uint64_t> m_head;              //!< index of the next record to write
+  std::atomic<uint64_t> m_tail;              //!< index of the next record to read
+  std::atomic<uint64_t> m_nDropped;          //!< number of dropped records
+};
+
+/**
+ * \ingroup wifi
+ *
+ * SuMuDecisionFileSink writes SU/MU decision records to a binary file. The
+ * file starts with a header made of the magic string "SMDT", the format
+ * version (uint16_t) and the size of a record (uint16_t), followed by the
+ * records in the byte order of the host.
+ */
+class SuMuDecisionFileSink : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SuMuDecisionFileSink ();
+  virtual ~SuMuDecisionFileSink ();
+
+  /// Version of the file format
+  static const uint16_t VERSION = 2;
+
+  /**
+   * Open the given file, truncating it, and write the header.
+   *
+   * \param filename the name of the file
+   */
+  void Open (const std::string& filename);
+  /**
+   * Close the file, if open.
+   */
+  void Close (void);
+  /**
+   * Write a record to the file. Can be connected to the SuMuDecision trace
+   * source of a scheduler.
+   *
+   * \param record the decision record
+   */
+  void Write (const SuMuDecisionRecord& record);
+  /**
+   * \return the number of records written
+   */
+  uint64_t GetNRecords (void) const;
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  std::ofstream m_file;    //!< the output file
+  uint64_t m_nRecords;     //!< number of records written
+};
+
+} //namespace ns3
+
+#endif /* SUMU_DECISION_TRACE_H */
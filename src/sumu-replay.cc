@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/object-factory.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/su-mu-selection-policy.h"
+#include "ns3/sumu-snapshot-log.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Replay the SU/MU selections logged by wifi_sumu15 (--snapshotLog) through a
+// set of selection policies and report the throughput they are predicted to
+// achieve and their regret with respect to the best format of each selection:
+//
+// ./waf --run "sumu-replay --log=snapshots.bin --policies=ns3::ThroughputSelectionPolicy,ns3::LatencyAwareSelectionPolicy"
+//
+// Policy attributes can be set as usual, e.g., --ns3::LatencyAwareSelectionPolicy::Objective=BoundedDelay.
+// Policies that learn from the feedback of the transmissions (ns3::SuMuBandit)
+// receive no feedback when replayed, hence they stick to the analytic choice.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("SuMuReplay");
+
+/**
+ * Statistics collected by replaying a policy
+ */
+struct ReplayStats
+{
+  uint64_t nSelections {0};   //!< number of selections
+  uint64_t nSu {0};           //!< number of times SU is selected
+  uint64_t nAgreements {0};   //!< number of times the logged format is selected
+  double throughputSum {0};   //!< sum of the predicted throughput of the selected formats (Mbps)
+  double regretSum {0};       //!< sum of the throughput lost with respect to the best format (Mbps)
+
+  /**
+   * Account for a selection.
+   *
+   * \param snapshot the inputs of the selection
+   * \param selected the selected format
+   * \param logged the format selected by the scheduler
+   */
+  void Add (const SuMuSnapshot& snapshot, MultiUserScheduler::TxFormat selected,
+            MultiUserScheduler::TxFormat logged)
+  {
+    double throughput = (selected == MultiUserScheduler::SU_TX ? snapshot.suThroughput
+                                                               : snapshot.muThroughput);
+    nSelections++;
+    nSu += (selected == MultiUserScheduler::SU_TX ? 1 : 0);
+    nAgreements += (selected == logged ? 1 : 0);
+    throughputSum += throughput;
+    regretSum += std::max (snapshot.suThroughput, snapshot.muThroughput) - throughput;
+  }
+
+  /**
+   * Print the statistics on a line.
+   *
+   * \param name the name of the policy
+   */
+  void Print (const std::string& name) const
+  {
+    double n = std::max<uint64_t> (nSelections, 1);
+    std::cout << std::left << std::setw (40) << name << std::right
+              << std::setw (10) << nSelections
+              << std::setw (10) << std::fixed << std::setprecision (1) << 100.0 * nSu / n
+              << std::setw (14) << std::setprecision (2) << throughputSum / n
+              << std::setw (14) << regretSum / n
+              << std::setw (12) << std::setprecision (1) << 100.0 * nAgreements / n
+              << std::endl;
+  }
+};
+
+int main (int argc, char *argv[])
+{
+  std::string log;
+  std::string policies = "ns3::ThroughputSelectionPolicy,ns3::QueueOccupancySelectionPolicy,"
+                         "ns3::LatencyTargetSelectionPolicy,ns3::LatencyAwareSelectionPolicy";
+
+  CommandLine cmd;
+  cmd.AddValue ("log", "Name of the SU/MU snapshot log to replay", log);
+  cmd.AddValue ("policies", "Comma-separated TypeIds of the selection policies to replay", policies);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (log.empty (), "The name of the snapshot log must be provided (--log)");
+
+  Ptr<SuMuSnapshotFileSource> source = CreateObject<SuMuSnapshotFileSource> ();
+  source->Open (log);
+
+  SuMuSnapshot snapshot;
+  MultiUserScheduler::TxFormat logged;
+  Time time;
+
+  std::cout << std::left << std::setw (40) << "Policy" << std::right
+            << std::setw (10) << "Count" << std::setw (10) << "SU (%)"
+            << std::setw (14) << "Tput (Mbps)" << std::setw (14) << "Regret (Mbps)"
+            << std::setw (12) << "Agree (%)" << std::endl;
+
+  // the selections actually taken by the scheduler
+  ReplayStats loggedStats;
+  while (source->Read (snapshot, logged, time))
+    {
+      loggedStats.Add (snapshot, logged, logged);
+    }
+  loggedStats.Print ("(logged)");
+
+  std::istringstream names (policies);
+  std::string name;
+  while (std::getline (names, name, ','))
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (name);
+      Ptr<SuMuSelectionPolicy> policy = factory.Create<SuMuSelectionPolicy> ();
+
+      ReplayStats stats;
+      source->Rewind ();
+      while (source->Read (snapshot, logged, time))
+        {
+          stats.Add (snapshot, policy->Select (snapshot), logged);
+        }
+      stats.Print (name);
+      policy->Dispose ();
+    }
+
+  source->Close ();
+  return 0;
+}
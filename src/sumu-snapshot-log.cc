@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "sumu-snapshot-log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SuMuSnapshotLog");
+
+namespace {
+
+/// Fixed-size part of a snapshot, as stored in the file
+struct SnapshotEntry
+{
+  int64_t timeNs;              //!< time of the selection (ns)
+  int64_t availableTimeNs;     //!< time available for the frame exchange (ns)
+  int64_t accessTimeNs;        //!< expected channel access time (ns)
+  int64_t suAirtimeNs;         //!< SU airtime (ns)
+  int64_t muAirtimeNs;         //!< DL MU airtime (ns)
+  double suThroughput;         //!< predicted SU throughput (Mbps)
+  double muThroughput;         //!< predicted DL MU throughput (Mbps)
+  uint32_t nQueuedPackets;     //!< packets queued by the AC
+  uint32_t queueCapacity;      //!< max packets in the queue
+  uint32_t suBytes;            //!< bytes sent in the SU PPDU
+  uint32_t muBytes;            //!< bytes sent in the DL MU PPDU
+  uint16_t nCandidates;        //!< number of candidate entries that follow
+  uint16_t muGroupSize;        //!< size of the DL MU group
+  uint16_t plannedMuGroupSize; //!< size of the DL MU group starting the TXOP plan
+  uint8_t txopPlanned;         //!< whether the TXOP has been planned
+  uint8_t format;              //!< selected format
+};
+
+/// A candidate of a snapshot, as stored in the file
+struct CandidateEntry
+{
+  int64_t holDelayNs;          //!< head-of-line delay (ns)
+  int64_t suAirtimeNs;         //!< SU airtime to the station (ns)
+  uint32_t mpduSize;           //!< size of the head-of-line MPDU
+  uint16_t aid;                //!< AID
+  uint16_t ampduLength;        //!< predicted DL MU A-MPDU length
+  uint8_t address[6];          //!< MAC address
+  uint8_t tid;                 //!< TID of the head-of-line MPDU
+  uint8_t mcs;                 //!< HE MCS
+};
+
+} // unnamed namespace
+
+
+NS_OBJECT_ENSURE_REGISTERED (SuMuSnapshotFileSink);
+
+TypeId
+SuMuSnapshotFileSink::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SuMuSnapshotFileSink")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<SuMuSnapshotFileSink> ()
+  ;
+  return tid;
+}
+
+SuMuSnapshotFileSink::SuMuSnapshotFileSink ()
+  : m_nRecords (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SuMuSnapshotFileSink::~SuMuSnapshotFileSink ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SuMuSnapshotFileSink::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+SuMuSnapshotFileSink::Open (const std::string& filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Close ();
+  m_file.open (filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_IF (!m_file.is_open (), "Cannot open file " << filename);
+
+  uint16_t header[3] = {VERSION, sizeof (SnapshotEntry), sizeof (CandidateEntry)};
+  m_file.write ("SMSL", 4);
+  m_file.write (reinterpret_cast<const char*> (header), sizeof (header));
+  m_nRecords = 0;
+}
+
+void
+SuMuSnapshotFileSink::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+}
+
+void
+SuMuSnapshotFileSink::Write (const SuMuSnapshot& snapshot, MultiUserScheduler::TxFormat format)
+{
+  NS_ASSERT (m_file.is_open ());
+
+  SnapshotEntry entry {};
+  entry.timeNs = Simulator::Now ().GetNanoSeconds ();
+  entry.availableTimeNs = snapshot.availableTime.GetNanoSeconds ();
+  entry.accessTimeNs = snapshot.accessTime.GetNanoSeconds ();
+  entry.suAirtimeNs = snapshot.suAirtime.GetNanoSeconds ();
+  entry.muAirtimeNs = snapshot.muAirtime.GetNanoSeconds ();
+  entry.suThroughput = snapshot.suThroughput;
+  entry.muThroughput = snapshot.muThroughput;
+  entry.nQueuedPackets = snapshot.nQueuedPackets;
+  entry.queueCapacity = snapshot.queueCapacity;
+  entry.suBytes = snapshot.suBytes;
+  entry.muBytes = snapshot.muBytes;
+  entry.nCandidates = static_cast<uint16_t> (snapshot.candidates.size ());
+  entry.muGroupSize = static_cast<uint16_t> (snapshot.muGroupSize);
+  entry.plannedMuGroupSize = static_cast<uint16_t> (snapshot.plannedMuGroupSize);
+  entry.txopPlanned = snapshot.txopPlanned;
+  entry.format = format;
+  m_file.write (reinterpret_cast<const char*> (&entry), sizeof (entry));
+
+  for (const auto& candidate : snapshot.candidates)
+    {
+      CandidateEntry candidateEntry {};
+      candidateEntry.holDelayNs = candidate.holDelay.GetNanoSeconds ();
+      candidateEntry.suAirtimeNs = candidate.suAirtime.GetNanoSeconds ();
+      candidateEntry.mpduSize = candidate.mpduSize;
+      candidateEntry.aid = candidate.aid;
+      candidateEntry.ampduLength = candidate.ampduLength;
+      candidate.address.CopyTo (candidateEntry.address);
+      candidateEntry.tid = candidate.tid;
+      candidateEntry.mcs = candidate.mcs;
+      m_file.write (reinterpret_cast<const char*> (&candidateEntry), sizeof (candidateEntry));
+    }
+  m_nRecords++;
+}
+
+uint64_t
+SuMuSnapshotFileSink::GetNRecords (void) const
+{
+  return m_nRecords;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (SuMuSnapshotFileSource);
+
+TypeId
+SuMuSnapshotFileSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SuMuSnapshotFileSource")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<SuMuSnapshotFileSource> ()
+  ;
+  return tid;
+}
+
+SuMuSnapshotFileSource::SuMuSnapshotFileSource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SuMuSnapshotFileSource::~SuMuSnapshotFileSource ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SuMuSnapshotFileSource::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+SuMuSnapshotFileSource::Open (const std::string& filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Close ();
+  m_file.open (filename, std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_IF (!m_file.is_open (), "Cannot open file " << filename);
+
+  char magic[4];
+  uint16_t header[3];
+  m_file.read (magic, sizeof (magic));
+  m_file.read (reinterpret_cast<char*> (header), sizeof (header));
+  NS_ABORT_MSG_IF (!m_file || std::string (magic, 4) != "SMSL",
+                   filename << " is not an SU/MU snapshot log");
+  NS_ABORT_MSG_IF (header[0] != SuMuSnapshotFileSink::VERSION
+                   || header[1] != sizeof (SnapshotEntry) || header[2] != sizeof (CandidateEntry),
+                   "Unsupported version (" << header[0] << ") or entry sizes of " << filename);
+}
+
+void
+SuMuSnapshotFileSource::Rewind (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_file.is_open ());
+  m_file.clear ();
+  m_file.seekg (4 + 3 * sizeof (uint16_t));
+}
+
+void
+SuMuSnapshotFileSource::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+}
+
+bool
+SuMuSnapshotFileSource::Read (SuMuSnapshot& snapshot, MultiUserScheduler::TxFormat& format, Time& time)
+{
+  NS_ASSERT (m_file.is_open ());
+
+  SnapshotEntry entry;
+  if (!m_file.read (reinterpret_cast<char*> (&entry), sizeof (entry)))
+    {
+      return false;
+    }
+
+  time = NanoSeconds (entry.timeNs);
+  format = static_cast<MultiUserScheduler::TxFormat> (entry.format);
+  snapshot.availableTime = NanoSeconds (entry.availableTimeNs);
+  snapshot.accessTime = NanoSeconds (entry.accessTimeNs);
+  snapshot.suAirtime = NanoSeconds (entry.suAirtimeNs);
+  snapshot.muAirtime = NanoSeconds (entry.muAirtimeNs);
+  snapshot.suThroughput = entry.suThroughput;
+  snapshot.muThroughput = entry.muThroughput;
+  snapshot.nQueuedPackets = entry.nQueuedPackets;
+  snapshot.queueCapacity = entry.queueCapacity;
+  snapshot.suBytes = entry.suBytes;
+  snapshot.muBytes = entry.muBytes;
+  snapshot.muGroupSize = entry.muGroupSize;
+  snapshot.plannedMuGroupSize = entry.plannedMuGroupSize;
+  snapshot.txopPlanned = entry.txopPlanned;
+
+  snapshot.candidates.resize (entry.nCandidates);
+  for (auto& candidate : snapshot.candidates)
+    {
+      CandidateEntry candidateEntry;
+      NS_ABORT_MSG_IF (!m_file.read (reinterpret_cast<char*> (&candidateEntry), sizeof (candidateEntry)),
+                       "Truncated snapshot log");
+      candidate.holDelay = NanoSeconds (candidateEntry.holDelayNs);
+      candidate.suAirtime = NanoSeconds (candidateEntry.suAirtimeNs);
+      candidate.mpduSize = candidateEntry.mpduSize;
+      candidate.aid = candidateEntry.aid;
+      candidate.ampduLength = candidateEntry.ampduLength;
+      candidate.address.CopyFrom (candidateEntry.address);
+      candidate.tid = candidateEntry.tid;
+      candidate.mcs = candidateEntry.mcs;
+    }
+  return true;
+}
+
+} //namespace ns3
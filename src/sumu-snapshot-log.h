@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SUMU_SNAPSHOT_LOG_H
+#define SUMU_SNAPSHOT_LOG_H
+
+#include "ns3/object.h"
+#include "su-mu-selection-policy.h"
+#include <fstream>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * SuMuSnapshotFileSink writes the inputs of the SU/MU selections of a
+ * scheduler, along with the selected format, to a binary file, so that
+ * selection policies can be evaluated offline on the same inputs.
+ *
+ * The file starts with a header made of the magic string "SMSL", the format
+ * version, the size of a snapshot entry and the size of a candidate entry
+ * (all uint16_t). Every snapshot entry is followed by as many candidate
+ * entries as the candidates of the snapshot. Entries are plain structs
+ * written in the byte order of the host.
+ */
+class SuMuSnapshotFileSink : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SuMuSnapshotFileSink ();
+  virtual ~SuMuSnapshotFileSink ();
+
+  /// Version of the file format
+  static const uint16_t VERSION = 1;
+
+  /**
+   * Open the given file, truncating it, and write the header.
+   *
+   * \param filename the name of the file
+   */
+  void Open (const std::string& filename);
+  /**
+   * Close the file, if open.
+   */
+  void Close (void);
+  /**
+   * Write a snapshot to the file. Can be connected to the SuMuSnapshot trace
+   * source of a scheduler.
+   *
+   * \param snapshot the inputs of the selection
+   * \param format the selected format
+   */
+  void Write (const SuMuSnapshot& snapshot, MultiUserScheduler::TxFormat format);
+  /**
+   * \return the number of snapshots written
+   */
+  uint64_t GetNRecords (void) const;
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  std::ofstream m_file;    //!< the output file
+  uint64_t m_nRecords;     //!< number of snapshots written
+};
+
+/**
+ * \ingroup wifi
+ *
+ * SuMuSnapshotFileSource reads the snapshots written by a SuMuSnapshotFileSink.
+ */
+class SuMuSnapshotFileSource : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SuMuSnapshotFileSource ();
+  virtual ~SuMuSnapshotFileSource ();
+
+  /**
+   * Open the given file and check its header.
+   *
+   * \param filename the name of the file
+   */
+  void Open (const std::string& filename);
+  /**
+   * Go back to the first snapshot.
+   */
+  void Rewind (void);
+  /**
+   * Close the file, if open.
+   */
+  void Close (void);
+  /**
+   * Read the next snapshot.
+   *
+   * \param snapshot the snapshot to fill
+   * \param format the format selected by the scheduler
+   * \param time the time of the selection
+   * \return false if there are no more snapshots
+   */
+  bool Read (SuMuSnapshot& snapshot, MultiUserScheduler::TxFormat& format, Time& time);
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  std::ifstream m_file;    //!< the input file
+};
+
+} //namespace ns3
+
+#endif /* SUMU_SNAPSHOT_LOG_H */
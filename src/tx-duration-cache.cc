@@ -0,0 +1,270 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "tx-duration-cache.h"
+#include "wifi-phy.h"
+#include "wifi-phy-state-helper.h"
+#include <algorithm>
+#include <iterator>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TxDurationCache");
+
+NS_OBJECT_ENSURE_REGISTERED (TxDurationCache);
+
+TypeId
+TxDurationCache::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TxDurationCache")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<TxDurationCache> ()
+    .AddAttribute ("MaxSize",
+                   "The maximum number of durations stored in the cache. When this "
+                   "number is reached, the least recently used duration is discarded.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&TxDurationCache::m_maxSize),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+TxDurationCache::TxDurationCache ()
+  : m_hits (0),
+    m_misses (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TxDurationCache::~TxDurationCache ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+TxDurationCache::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_DEBUG ("Duration cache hits=" << m_hits << " misses=" << m_misses);
+  SetWifiPhy (0);
+  Flush ();
+  Object::DoDispose ();
+}
+
+void
+TxDurationCache::SetWifiPhy (Ptr<WifiPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+
+  if (m_phy != 0)
+    {
+      m_phy->GetState ()->TraceDisconnectWithoutContext ("State",
+                                                         MakeCallback (&TxDurationCache::NotifyPhyState, this));
+    }
+  m_phy = phy;
+  if (m_phy != 0)
+    {
+      m_phy->GetState ()->TraceConnectWithoutContext ("State",
+                                                      MakeCallback (&TxDurationCache::NotifyPhyState, this));
+    }
+}
+
+void
+TxDurationCache::NotifyPhyState (Time start, Time duration, WifiPhyState state)
+{
+  if (state == WifiPhyState::SWITCHING)
+    {
+      NS_LOG_DEBUG ("The PHY is switching channel, flushing the duration cache");
+      Flush ();
+    }
+}
+
+bool
+TxDurationCache::Key::operator== (const Key& other) const
+{
+  return txVectorInfo == other.txVectorInfo
+         && psduSize == other.psduSize
+         && staId == other.staId
+         && nUsers == other.nUsers
+         && std::equal (users, users + nUsers, other.users);
+}
+
+std::size_t
+TxDurationCache::KeyHash::operator() (const Key& key) const
+{
+  // FNV-1a like combination of the key fields
+  uint64_t hash = 14695981039346656037ULL;
+  auto combine = [&hash] (uint64_t value)
+    {
+      hash ^= value;
+      hash *= 1099511628211ULL;
+    };
+  combine (key.txVectorInfo);
+  combine ((static_cast<uint64_t> (key.psduSize) << 32)
+           | (static_cast<uint64_t> (key.staId) << 16) | key.nUsers);
+  for (uint16_t i = 0; i < key.nUsers; i++)
+    {
+      combine (key.users[i]);
+    }
+  return static_cast<std::size_t> (hash);
+}
+
+bool
+TxDurationCache::MakeKey (Key& key, uint32_t size, const WifiTxVector& txVector, WifiPhyBand band,
+                          uint16_t staId, bool preambleOnly)
+{
+  key.txVectorInfo = static_cast<uint64_t> (txVector.GetPreambleType ())
+                     | (static_cast<uint64_t> (txVector.GetChannelWidth ()) << 8)
+                     | (static_cast<uint64_t> (txVector.GetGuardInterval ()) << 24)
+                     | (static_cast<uint64_t> (band) << 40)
+                     | (static_cast<uint64_t> (txVector.IsStbc ()) << 48)
+                     | (static_cast<uint64_t> (txVector.GetNess ()) << 49)
+                     | (static_cast<uint64_t> (preambleOnly) << 52);
+  key.psduSize = size;
+  key.staId = staId;
+  key.nUsers = 0;
+
+  if (txVector.IsMu ())
+    {
+      // The duration of HE-SIG-B depends on the RU allocation of all the users
+      if (txVector.GetHeMuUserInfoMap ().size () > MAX_USERS)
+        {
+          return false;
+        }
+      for (const auto& userInfo : txVector.GetHeMuUserInfoMap ())
+        {
+          key.users[key.nUsers++] = static_cast<uint64_t> (userInfo.first)
+                                    | (static_cast<uint64_t> (userInfo.second.ru.GetRuType ()) << 16)
+                                    | (static_cast<uint64_t> (userInfo.second.ru.GetIndex ()) << 19)
+                                    | (static_cast<uint64_t> (userInfo.second.ru.GetPrimary80MHz ()) << 26)
+                                    | (static_cast<uint64_t> (userInfo.second.mcs.GetUid ()) << 27)
+                                    | (static_cast<uint64_t> (userInfo.second.nss) << 43);
+        }
+    }
+  else
+    {
+      key.users[key.nUsers++] = static_cast<uint64_t> (txVector.GetMode ().GetUid ())
+                                | (static_cast<uint64_t> (txVector.GetNss ()) << 16);
+    }
+  return true;
+}
+
+bool
+TxDurationCache::Lookup (const Key& key, Time& duration)
+{
+  auto it = m_index.find (key);
+
+  if (it == m_index.end ())
+    {
+      m_misses++;
+      return false;
+    }
+  m_hits++;
+  // move the entry to the front of the LRU list
+  m_entries.splice (m_entries.begin (), m_entries, it->second);
+  duration = it->second->duration;
+  return true;
+}
+
+Time
+TxDurationCache::Insert (const Key& key, Time duration)
+{
+  if (m_index.empty ())
+    {
+      m_index.reserve (m_maxSize);
+    }
+  if (m_entries.size () >= m_maxSize)
+    {
+      // reuse the least recently used entry
+      m_index.erase (m_entries.back ().key);
+      m_entries.splice (m_entries.begin (), m_entries, std::prev (m_entries.end ()));
+      m_entries.front () = {key, duration};
+    }
+  else
+    {
+      m_entries.push_front ({key, duration});
+    }
+  m_index.emplace (key, m_entries.begin ());
+  return duration;
+}
+
+Time
+TxDurationCache::CalculateTxDuration (uint32_t size, const WifiTxVector& txVector, WifiPhyBand band,
+                                      uint16_t staId)
+{
+  Key key;
+  Time duration;
+
+  if (!MakeKey (key, size, txVector, band, staId, false))
+    {
+      m_misses++;
+      return WifiPhy::CalculateTxDuration (size, txVector, band, staId);
+    }
+  if (Lookup (key, duration))
+    {
+      return duration;
+    }
+  return Insert (key, WifiPhy::CalculateTxDuration (size, txVector, band, staId));
+}
+
+Time
+TxDurationCache::CalculatePhyPreambleAndHeaderDuration (const WifiTxVector& txVector)
+{
+  Key key;
+  Time duration;
+
+  if (!MakeKey (key, 0, txVector, WIFI_PHY_BAND_UNSPECIFIED, SU_STA_ID, true))
+    {
+      m_misses++;
+      return WifiPhy::CalculatePhyPreambleAndHeaderDuration (txVector);
+    }
+  if (Lookup (key, duration))
+    {
+      return duration;
+    }
+  return Insert (key, WifiPhy::CalculatePhyPreambleAndHeaderDuration (txVector));
+}
+
+void
+TxDurationCache::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_index.clear ();
+  m_entries.clear ();
+}
+
+uint64_t
+TxDurationCache::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+TxDurationCache::GetMisses (void) const
+{
+  return m_misses;
+}
+
+std::size_t
+TxDurationCache::GetSize (void) const
+{
+  return m_entries.size ();
+}
+
+} //namespace ns3
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TX_DURATION_CACHE_H
+#define TX_DURATION_CACHE_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/wifi-phy-band.h"
+#include "ns3/wifi-tx-vector.h"
+#include "ns3/wifi-phy-state.h"
+#include <list>
+#include <unordered_map>
+
+namespace ns3 {
+
+class WifiPhy;
+
+/**
+ * \ingroup wifi
+ *
+ * TxDurationCache memoizes the results of WifiPhy::CalculateTxDuration and
+ * WifiPhy::CalculatePhyPreambleAndHeaderDuration. Entries are keyed on the
+ * TXVECTOR fields the durations depend on (preamble type, channel width, guard
+ * interval, modulation and, for HE MU and HE TB PPDUs, the RU allocation of all
+ * the users), the PSDU size, the band and the STA-ID. Keys are fixed-size, hence
+ * a lookup does not allocate memory; the durations of MU PPDUs with more than
+ * MAX_USERS users are not cached.
+ *
+ * The cache is bounded: when the maximum number of entries is reached, the
+ * least recently used entry is discarded. Since keys include the channel width
+ * and the band, entries computed for a previous configuration of the PHY are
+ * never hit; the cache is nonetheless flushed when the PHY monitored via
+ * SetWifiPhy switches channel, so that such entries do not take up space.
+ */
+class TxDurationCache : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  TxDurationCache ();
+  virtual ~TxDurationCache ();
+
+  /// Maximum number of users of an MU PPDU whose duration can be cached
+  static const std::size_t MAX_USERS = 16;
+
+  /**
+   * Monitor the given PHY, so that the cache is flushed when it switches
+   * channel (thus possibly changing its channel width and band).
+   *
+   * \param phy the PHY to monitor (null to stop monitoring)
+   */
+  void SetWifiPhy (Ptr<WifiPhy> phy);
+
+  /**
+   * Cached version of WifiPhy::CalculateTxDuration.
+   *
+   * \param size the number of bytes in the PSDU
+   * \param txVector the TXVECTOR used for the transmission of the PSDU
+   * \param band the frequency band
+   * \param staId the STA-ID of the PSDU (only used for MU PPDUs)
+   * \return the total amount of time this PHY will stay busy for the transmission of the PPDU
+   */
+  Time CalculateTxDuration (uint32_t size, const WifiTxVector& txVector, WifiPhyBand band,
+                            uint16_t staId = SU_STA_ID);
+
+  /**
+   * Cached version of WifiPhy::CalculatePhyPreambleAndHeaderDuration.
+   *
+   * \param txVector the transmission parameters
+   * \return the total amount of time this PHY will stay busy for the transmission of the PHY preamble and PHY header
+   */
+  Time CalculatePhyPreambleAndHeaderDuration (const WifiTxVector& txVector);
+
+  /**
+   * Discard all the entries of the cache.
+   */
+  void Flush (void);
+
+  /**
+   * \return the number of lookups that found a cached duration
+   */
+  uint64_t GetHits (void) const;
+  /**
+   * \return the number of lookups that required to compute the duration
+   */
+  uint64_t GetMisses (void) const;
+  /**
+   * \return the number of entries currently stored
+   */
+  std::size_t GetSize (void) const;
+
+protected:
+  void DoDispose (void) override;
+
+private:
+  /// Key identifying a cached duration
+  struct Key
+  {
+    uint64_t txVectorInfo;        //!< preamble, width, GI, band and flags
+    uint32_t psduSize;            //!< PSDU size (0 for preamble and header durations)
+    uint16_t staId;               //!< STA-ID
+    uint16_t nUsers;              //!< number of valid entries in users
+    uint64_t users[MAX_USERS];    //!< modulation and RU allocation of the users
+
+    /**
+     * \param other the other key
+     * \return true if the two keys are equal
+     */
+    bool operator== (const Key& other) const;
+  };
+
+  /// Hash function for cache keys
+  struct KeyHash
+  {
+    /**
+     * \param key the key
+     * \return the hash value of the key
+     */
+    std::size_t operator() (const Key& key) const;
+  };
+
+  /// Cached duration
+  struct Entry
+  {
+    Key key;                      //!< the key of the entry
+    Time duration;                //!< the cached duration
+  };
+
+  /// Cached durations, the most recently used first
+  typedef std::list<Entry> EntryList;
+
+  /**
+   * Build the key for the given parameters.
+   *
+   * \param key the key to fill
+   * \param size the PSDU size
+   * \param txVector the TXVECTOR
+   * \param band the frequency band
+   * \param staId the STA-ID
+   * \param preambleOnly whether the key refers to the preamble and header duration
+   * \return false if the TXVECTOR has too many users for the duration to be cached
+   */
+  static bool MakeKey (Key& key, uint32_t size, const WifiTxVector& txVector, WifiPhyBand band,
+                       uint16_t staId, bool preambleOnly);
+
+  /**
+   * Look up the given key and, if found, mark the entry as the most recently used.
+   *
+   * \param key the key
+   * \param duration set to the cached duration, if found
+   * \return true if the key has been found
+   */
+  bool Lookup (const Key& key, Time& duration);
+
+  /**
+   * Store the given duration, discarding the least recently used entry if the
+   * cache is full.
+   *
+   * \param key the key
+   * \param duration the duration
+   * \return the stored duration
+   */
+  Time Insert (const Key& key, Time duration);
+
+  /**
+   * Callback connected to the State trace source of the PHY state helper.
+   *
+   * \param start the time the state started
+   * \param duration the duration of the state
+   * \param state the state
+   */
+  void NotifyPhyState (Time start, Time duration, WifiPhyState state);
+
+  uint32_t m_maxSize;                                   //!< max number of entries
+  EntryList m_entries;                                  //!< cached durations, in LRU order
+  std::unordered_map<Key, EntryList::iterator, KeyHash> m_index; //!< cached durations indexed by key
+  uint64_t m_hits;                                      //!< number of cache hits
+  uint64_t m_misses;                                    //!< number of cache misses
+  Ptr<WifiPhy> m_phy;                                   //!< the monitored PHY
+};
+
+} //namespace ns3
+
+#endif /* TX_DURATION_CACHE_H */
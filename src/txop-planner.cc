@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "txop-planner.h"
+#include <algorithm>
+
+namespace ns3 {
+
+TxopPlanner::TxopPlanner ()
+  : m_muGroupSize (0),
+    m_bytes (0)
+{
+}
+
+void
+TxopPlanner::Clear (void)
+{
+  m_suPpdus.clear ();
+  m_muPpdus.clear ();
+  m_muGroupSize = 0;
+  m_suBursts.clear ();
+  m_bytes = 0;
+}
+
+void
+TxopPlanner::AddSuPpdu (std::size_t candidate, Time duration, uint32_t bytes)
+{
+  m_suPpdus.push_back ({candidate, duration, bytes});
+}
+
+void
+TxopPlanner::AddMuPpdu (std::size_t groupSize, Time duration, uint32_t bytes)
+{
+  NS_ASSERT (groupSize > 0);
+  m_muPpdus.push_back ({groupSize, duration, bytes});
+}
+
+uint64_t
+TxopPlanner::FillWithSuPpdus (std::size_t firstCandidate, Time time, Time gap,
+                              std::vector<std::size_t>& bursts) const
+{
+  bursts.clear ();
+  uint64_t bytes = 0;
+  Time left = time;
+  const Ppdu* largest = nullptr;
+
+  // m_suPpdus is sorted in decreasing order of bytes per airtime
+  for (const auto& ppdu : m_suPpdus)
+    {
+      if (ppdu.candidates < firstCandidate || gap + ppdu.duration > time)
+        {
+          continue;
+        }
+      if (largest == nullptr || ppdu.bytes > largest->bytes)
+        {
+          largest = &ppdu;
+        }
+      if (gap + ppdu.duration <= left)
+        {
+          bursts.push_back (ppdu.candidates);
+          bytes += ppdu.bytes;
+          left -= gap + ppdu.duration;
+        }
+    }
+
+  if (largest != nullptr && largest->bytes > bytes)
+    {
+      bursts.assign (1, largest->candidates);
+      bytes = largest->bytes;
+    }
+  return bytes;
+}
+
+void
+TxopPlanner::Plan (Time txopDuration, Time gap)
+{
+  auto suIt = std::find_if (m_suPpdus.begin (), m_suPpdus.end (),
+                            [] (const Ppdu& ppdu) { return ppdu.candidates == 0; });
+  NS_ASSERT_MSG (suIt != m_suPpdus.end (), "No SU PPDU for the first candidate");
+  Ppdu firstSu = *suIt;
+
+  std::stable_sort (m_suPpdus.begin (), m_suPpdus.end (),
+                    [] (const Ppdu& a, const Ppdu& b)
+                    { return a.bytes * b.duration.GetNanoSeconds ()
+                             > b.bytes * a.duration.GetNanoSeconds (); });
+
+  std::vector<std::size_t> bursts;
+
+  // first PPDU: SU PPDU to the first candidate
+  m_muGroupSize = 0;
+  m_bytes = 0;
+  m_suBursts.clear ();
+  if (firstSu.duration <= txopDuration)
+    {
+      m_bytes = firstSu.bytes + FillWithSuPpdus (1, txopDuration - firstSu.duration, gap, m_suBursts);
+    }
+
+  // first PPDU: DL MU PPDU to the first k candidates
+  for (const auto& mu : m_muPpdus)
+    {
+      if (mu.duration > txopDuration)
+        {
+          continue;
+        }
+      uint64_t bytes = mu.bytes + FillWithSuPpdus (mu.candidates, txopDuration - mu.duration, gap, bursts);
+      if (bytes > m_bytes)
+        {
+          m_bytes = bytes;
+          m_muGroupSize = mu.candidates;
+          m_suBursts.swap (bursts);
+        }
+    }
+}
+
+std::size_t
+TxopPlanner::GetMuGroupSize (void) const
+{
+  return m_muGroupSize;
+}
+
+const std::vector<std::size_t>&
+TxopPlanner::GetSuBursts (void) const
+{
+  return m_suBursts;
+}
+
+uint64_t
+TxopPlanner::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+} //namespace ns3
@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TXOP_PLANNER_H
+#define TXOP_PLANNER_H
+
+#include "ns3/nstime.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * TxopPlanner determines the sequence of PPDUs an AP sends in a TXOP so that
+ * the number of bytes delivered within the TXOP is maximized. Candidate
+ * stations are identified by their index in the list of candidates of the
+ * scheduler. The first PPDU of the TXOP is either an SU PPDU sent to the
+ * first candidate or a DL MU PPDU sent to the first k candidates, for any k
+ * for which a DL MU PPDU has been added. The rest of the TXOP is filled with
+ * SU PPDUs sent to the candidates not served by the first PPDU.
+ *
+ * Filling the rest of the TXOP is a knapsack problem, which is solved by
+ * taking the better of the greedy solution (SU PPDUs in decreasing order of
+ * bytes per unit of airtime) and the single SU PPDU carrying the most bytes,
+ * which is guaranteed to deliver at least half of the optimal number of bytes
+ * and takes O(n log n) time.
+ */
+class TxopPlanner
+{
+public:
+  TxopPlanner ();
+
+  /**
+   * Remove all the PPDUs added and the current plan.
+   */
+  void Clear (void);
+  /**
+   * Add an SU PPDU that can be sent to the given candidate.
+   *
+   * \param candidate the index of the candidate
+   * \param duration the duration of the frame exchange
+   * \param bytes the number of bytes delivered
+   */
+  void AddSuPpdu (std::size_t candidate, Time duration, uint32_t bytes);
+  /**
+   * Add a DL MU PPDU that can be sent to the first groupSize candidates.
+   *
+   * \param groupSize the number of candidates served by the DL MU PPDU
+   * \param duration the duration of the frame exchange
+   * \param bytes the number of bytes delivered
+   */
+  void AddMuPpdu (std::size_t groupSize, Time duration, uint32_t bytes);
+
+  /**
+   * Determine the sequence of PPDUs delivering the most bytes in the given
+   * time. An SU PPDU must have been added for the first candidate. A PPDU
+   * whose frame exchange does not fit in the given time is never selected as
+   * the first PPDU; if none fits, the plan is an SU PPDU to the first
+   * candidate delivering no bytes within the TXOP.
+   *
+   * \param txopDuration the time available in the TXOP
+   * \param gap the time between two consecutive frame exchanges in the TXOP
+   */
+  void Plan (Time txopDuration, Time gap);
+
+  /**
+   * \return the number of candidates served by the first PPDU if it is a DL MU
+   *         PPDU, zero if the first PPDU is an SU PPDU sent to the first candidate
+   */
+  std::size_t GetMuGroupSize (void) const;
+  /**
+   * \return the indices of the candidates that are sent an SU PPDU after the
+   *         first PPDU, in transmission order
+   */
+  const std::vector<std::size_t>& GetSuBursts (void) const;
+  /**
+   * \return the number of bytes delivered by the planned sequence
+   */
+  uint64_t GetBytes (void) const;
+
+private:
+  /// A PPDU that can be sent in the TXOP
+  struct Ppdu
+  {
+    std::size_t candidates;  //!< candidate index (SU) or number of candidates served (MU)
+    Time duration;           //!< duration of the frame exchange
+    uint32_t bytes;          //!< bytes delivered
+  };
+
+  /**
+   * Fill the given time with SU PPDUs sent to the candidates having an index
+   * not less than the given one.
+   *
+   * \param firstCandidate the index of the first candidate that can be served
+   * \param time the time available
+   * \param gap the time between two consecutive frame exchanges
+   * \param bursts the indices of the candidates that are sent an SU PPDU
+   * \return the number of bytes delivered by the SU PPDUs
+   */
+  uint64_t FillWithSuPpdus (std::size_t firstCandidate, Time time, Time gap,
+                            std::vector<std::size_t>& bursts) const;
+
+  std::vector<Ppdu> m_suPpdus;            //!< SU PPDUs, sorted by bytes per airtime when planning
+  std::vector<Ppdu> m_muPpdus;            //!< DL MU PPDUs
+  std::size_t m_muGroupSize;              //!< group size of the first PPDU (0 for SU)
+  std::vector<std::size_t> m_suBursts;    //!< SU PPDUs following the first PPDU
+  uint64_t m_bytes;                       //!< bytes delivered by the plan
+};
+
+} //namespace ns3
+
+#endif /* TXOP_PLANNER_H */
@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "weighted-ru-allocator.h"
+#include "ru-layout.h"
+#include <algorithm>
+#include <numeric>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WeightedRuAllocator");
+
+WeightedRuAllocator::WeightedRuAllocator (uint16_t bw)
+  : m_bw (bw)
+{
+  NS_LOG_FUNCTION (this << bw);
+}
+
+uint16_t
+WeightedRuAllocator::GetNTones (HeRu::RuType ruType)
+{
+  switch (ruType)
+    {
+      case HeRu::RU_26_TONE:
+        return 26;
+      case HeRu::RU_52_TONE:
+        return 52;
+      case HeRu::RU_106_TONE:
+        return 106;
+      case HeRu::RU_242_TONE:
+        return 242;
+      case HeRu::RU_484_TONE:
+        return 484;
+      case HeRu::RU_996_TONE:
+        return 996;
+      case HeRu::RU_2x996_TONE:
+        return 2 * 996;
+      default:
+        NS_ABORT_MSG ("Unknown RU type");
+    }
+  return 0;
+}
+
+std::map<std::size_t, HeRu::RuSpec>
+WeightedRuAllocator::Allocate (const std::vector<double>& weights) const
+{
+  NS_LOG_FUNCTION (this << weights.size ());
+
+  std::vector<std::size_t> users (weights.size ());
+  std::iota (users.begin (), users.end (), 0);
+  std::stable_sort (users.begin (), users.end (),
+                    [&weights] (std::size_t a, std::size_t b) { return weights[a] > weights[b]; });
+
+  std::map<std::size_t, HeRu::RuSpec> allocation;
+  if (users.empty ())
+    {
+      return allocation;
+    }
+
+  std::size_t nRus = RuLayout::GetNRus (m_bw, HeRu::RU_26_TONE);
+  if (users.size () > nRus)
+    {
+      NS_LOG_DEBUG ("No RU left for the " << users.size () - nRus << " lightest users");
+      users.resize (nRus);
+    }
+
+  // the RU type covering the whole channel
+  std::size_t nCentral26TonesRus;
+  HeRu::RuType rootType = HeRu::GetEqualSizedRusForStations (m_bw, 1, nCentral26TonesRus);
+
+  std::vector<HeRu::RuType> ruTypes (users.size (), HeRu::RU_26_TONE);
+  std::vector<HeRu::RuSpec> rus;
+  bool placed = Place (ruTypes, rus);
+  NS_ASSERT (placed);
+
+  // grow the RU of the user needing the most time per tone until it cannot
+  // grow any further, as the duration of the DL MU PPDU would not decrease
+  while (true)
+    {
+      std::size_t bottleneck = 0;
+      for (std::size_t i = 1; i < users.size (); i++)
+        {
+          if (weights[users[i]] * GetNTones (ruTypes[bottleneck])
+              > weights[users[bottleneck]] * GetNTones (ruTypes[i]))
+            {
+              bottleneck = i;
+            }
+        }
+      if (ruTypes[bottleneck] == rootType)
+        {
+          break;
+        }
+
+      ruTypes[bottleneck] = static_cast<HeRu::RuType> (ruTypes[bottleneck] + 1);
+      std::vector<HeRu::RuSpec> grown;
+      if (!Place (ruTypes, grown))
+        {
+          ruTypes[bottleneck] = static_cast<HeRu::RuType> (ruTypes[bottleneck] - 1);
+          break;
+        }
+      rus.swap (grown);
+    }
+
+  for (std::size_t i = 0; i < users.size (); i++)
+    {
+      NS_LOG_DEBUG ("User " << users[i] << " allocated RU " << rus[i]);
+      allocation.insert ({users[i], rus[i]});
+    }
+  return allocation;
+}
+
+bool
+WeightedRuAllocator::Place (const std::vector<HeRu::RuType>& ruTypes, std::vector<HeRu::RuSpec>& rus) const
+{
+  std::vector<std::size_t> order (ruTypes.size ());
+  std::iota (order.begin (), order.end (), 0);
+  std::stable_sort (order.begin (), order.end (),
+                    [&ruTypes] (std::size_t a, std::size_t b) { return ruTypes[a] > ruTypes[b]; });
+
+  // 26-tone RUs covered by the RUs placed so far, per 80 MHz segment (index 0
+  // is unused, as RU indices start at 1)
+  std::size_t nSegments = (m_bw == 160 ? 2 : 1);
+  std::size_t n26TonesRus = RuLayout::GetNRus (m_bw, HeRu::RU_26_TONE) / nSegments;
+  std::vector<bool> occupied[2] {std::vector<bool> (n26TonesRus + 1, false),
+                                 std::vector<bool> (n26TonesRus + 1, false)};
+
+  rus.assign (ruTypes.size (), HeRu::RuSpec ());
+
+  for (std::size_t i : order)
+    {
+      if (ruTypes[i] == HeRu::RU_2x996_TONE)
+        {
+          // the RU covers the whole channel
+          if (ruTypes.size () > 1)
+            {
+              return false;
+            }
+          rus[i] = HeRu::RuSpec {HeRu::RU_2x996_TONE, 1, true};
+          continue;
+        }
+
+      bool found = false;
+      for (std::size_t pos = 0; pos < RuLayout::GetNRus (m_bw, ruTypes[i]) && !found; pos++)
+        {
+          HeRu::RuSpec ru = RuLayout::GetRu (m_bw, ruTypes[i], pos);
+          std::vector<bool>& segment = occupied[ru.GetPrimary80MHz () ? 0 : 1];
+          std::pair<std::size_t, std::size_t> range = GetCovered26TonesRus (ru);
+          NS_ASSERT (range.second < segment.size ());
+
+          if (std::find (segment.begin () + range.first, segment.begin () + range.second + 1, true)
+              == segment.begin () + range.second + 1)
+            {
+              std::fill (segment.begin () + range.first, segment.begin () + range.second + 1, true);
+              rus[i] = ru;
+              found = true;
+            }
+        }
+      if (!found)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+std::pair<std::size_t, std::size_t>
+WeightedRuAllocator::GetCovered26TonesRus (const HeRu::RuSpec& ru)
+{
+  // index of the first 26-tone RU of the given 20 MHz subchannel of an 80 MHz
+  // segment, taking into account the 26-tone RU at the center of the segment
+  auto first26TonesRu = [] (std::size_t subchannel) -> std::size_t
+    { return 9 * subchannel + (subchannel >= 2 ? 1 : 0) + 1; };
+
+  std::size_t index = ru.GetIndex ();
+  NS_ASSERT (index > 0);
+  std::size_t first;
+
+  switch (ru.GetRuType ())
+    {
+      case HeRu::RU_26_TONE:
+        return {index, index};
+      case HeRu::RU_52_TONE:
+        // the two 52-tone RUs after the central 26-tone RU of the subchannel
+        // are shifted by one 26-tone RU
+        first = first26TonesRu ((index - 1) / 4) + 2 * ((index - 1) % 4) + ((index - 1) % 4 >= 2 ? 1 : 0);
+        return {first, first + 1};
+      case HeRu::RU_106_TONE:
+        first = first26TonesRu ((index - 1) / 2) + 5 * ((index - 1) % 2);
+        return {first, first + 3};
+      case HeRu::RU_242_TONE:
+        first = first26TonesRu (index - 1);
+        return {first, first + 8};
+      case HeRu::RU_484_TONE:
+        return {first26TonesRu (2 * (index - 1)), first26TonesRu (2 * (index - 1) + 1) + 8};
+      case HeRu::RU_996_TONE:
+        return {1, 37};
+      default:
+        NS_ABORT_MSG ("Unsupported RU type: " << ru.GetRuType ());
+    }
+  return {0, 0};
+}
+
+} //namespace ns3
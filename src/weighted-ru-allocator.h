@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WEIGHTED_RU_ALLOCATOR_H
+#define WEIGHTED_RU_ALLOCATOR_H
+
+#include "he-ru.h"
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * WeightedRuAllocator allocates RUs of possibly different sizes to a set of
+ * users, each having a weight proportional to the number of tones the user
+ * needs (e.g., the time needed to transmit its queued bytes over the whole
+ * channel). RUs are sized by weight share: every user starts with a 26-tone
+ * RU and the user having the highest weight per allocated tone is repeatedly
+ * given the RU of the next larger size (26 -> 52 -> 106 -> 242 -> 484 -> 996
+ * -> 2x996 tones), as long as the RUs of all the users can still be placed in
+ * the channel. The PSDU durations are therefore equalized as far as the RU
+ * sizes allow.
+ *
+ * RUs are placed by decreasing size, each at the first position of its type
+ * that does not overlap the RUs already placed, which is guaranteed to find a
+ * placement whenever one exists. Every RU covers a contiguous range of 26-tone
+ * RUs (central 26-tone RUs included) in its 80 MHz segment, hence overlaps are
+ * detected on a map of the 26-tone RUs, and central 26-tone RUs not covered by
+ * larger RUs can be allocated.
+ */
+class WeightedRuAllocator
+{
+public:
+  /**
+   * Create an allocator for the given channel width.
+   *
+   * \param bw the channel width in MHz
+   */
+  WeightedRuAllocator (uint16_t bw);
+
+  /**
+   * Allocate RUs to the given users. If there are more users than 26-tone
+   * RUs (central 26-tone RUs included), the users with the smallest weights
+   * are not allocated an RU.
+   *
+   * \param weights the weight of every user
+   * \return the RU allocated to every user that has been allocated an RU,
+   *         indexed by the position of the user in the given vector
+   */
+  std::map<std::size_t, HeRu::RuSpec> Allocate (const std::vector<double>& weights) const;
+
+  /**
+   * \param ruType the RU type
+   * \return the number of tones of an RU of the given type
+   */
+  static uint16_t GetNTones (HeRu::RuType ruType);
+
+private:
+  /**
+   * Place RUs of the given types in the channel, by decreasing size.
+   *
+   * \param ruTypes the type of the RU of every user
+   * \param rus the RU placed for every user (filled only if all the RUs are placed)
+   * \return true if all the RUs have been placed
+   */
+  bool Place (const std::vector<HeRu::RuType>& ruTypes, std::vector<HeRu::RuSpec>& rus) const;
+  /**
+   * \param ru the RU (not a 2x996-tone RU)
+   * \return the indices of the first and the last 26-tone RU (central 26-tone
+   *         RUs included) covered by the given RU in its 80 MHz segment
+   */
+  static std::pair<std::size_t, std::size_t> GetCovered26TonesRus (const HeRu::RuSpec& ru);
+
+  uint16_t m_bw;   //!< the channel width in MHz
+};
+
+} //namespace ns3
+
+#endif /* WEIGHTED_RU_ALLOCATOR_H */
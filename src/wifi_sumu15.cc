@@ -26,7 +26,10 @@
 #include "ns3/ctrl-headers.h"
 #include "ns3/traffic-control-helper.h"
 #include "ns3/rr-sumu-scheduler.h"
+#include "ns3/sumu-decision-trace.h"
+#include "ns3/sumu-snapshot-log.h"
 #include "ns3/he-phy.h" // ns3/headerfile tells you  that when ns3 compiles module files, it  creates a shared object file in which all header files are put
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <cmath>
@@ -101,6 +104,11 @@ public:
    */
   void StopStatistics (void);
 
+  /**
+   * Print the 50th, 95th and 99th percentiles of the latencies of all the stations.
+   */
+  void PrintLatencyPercentiles (const std::map<uint32_t, std::vector<Time>>& latencyMap);
+
   void NotifyChannelAccessGranted(void);
   /**
    * Report that an MPDU was not correctly received.
@@ -147,6 +155,21 @@ public:
    */
   void NotifyPsduMapForwardedDown (WifiConstPsduMap psduMap, WifiTxVector txVector);
 
+  /**
+   * Store the SU airtime predicted by the scheduler when it selects SU.
+   */
+  void NotifySuMuDecision (const SuMuDecisionRecord& record);
+
+  /**
+   * Start measuring the airtime of an SU frame exchange whose airtime was predicted.
+   */
+  void NotifySuPsduForwardedDown (Ptr<const WifiPsdu> psdu, WifiTxVector txVector);
+
+  /**
+   * Stop measuring the airtime of an SU frame exchange when the BlockAck is received.
+   */
+  void NotifyApAckedMpdu (Ptr<const WifiMacQueueItem> mpdu);
+
   /**
    * Report that the application has received a new packet. (App layer)
    */
@@ -195,6 +218,8 @@ private:
   bool m_enableDlOfdma;
   bool m_enableUlOfdma;
   bool m_useCentral26TonesRus;
+  bool m_weightedRus;       // size RUs by backlog and MCS (scheduler 2 only)
+  bool m_txopPlanning;      // plan the PPDUs sent in a TXOP (scheduler 2 only)
   uint16_t m_channelWidth;  // channel bandwidth
   uint8_t m_channelNumber;
   uint16_t m_channelCenterFrequency;
@@ -213,6 +238,19 @@ private:
   bool m_randomizeDataRate;
   std::string m_transport;
   std::string m_queueDisc, m_pcap;
+  std::string m_decisionTrace;  // name of the binary file storing the SU/MU decisions
+  std::string m_suMuPolicy;     // TypeId of the SU/MU selection policy (scheduler 2 only)
+  std::string m_snapshotLog;    // name of the binary file storing the inputs of the SU/MU selections
+  Ptr<SuMuDecisionFileSink> m_decisionSink;
+  Ptr<SuMuSnapshotFileSink> m_snapshotSink;
+  bool m_validateSuAirtime;     // compare the predicted and the measured SU airtime (scheduler 2 only)
+  Time m_predictedSuAirtime;    // SU airtime predicted by the last decision, if SU was selected
+  Mac48Address m_suReceiver;    // receiver of the SU frame exchange predicted by the last decision
+  Time m_suTxStart;             // start of the SU frame exchange being measured
+  uint64_t m_nSuAirtimeSamples;
+  double m_suPredictedAirtimeSum; // microseconds
+  double m_suMeasuredAirtimeSum;  // microseconds
+  double m_suAirtimeErrorSum;     // sum of the relative errors (absolute value)
   double m_warmup;          // duration of the warmup period (seconds)
   std::size_t m_currentSta; // index of the current station
   Ssid m_ssid;
@@ -284,6 +322,8 @@ WifiDlOfdma::WifiDlOfdma ()
     m_enableDlOfdma (true),
     m_enableUlOfdma(false),
     m_useCentral26TonesRus(false),
+    m_weightedRus(false),
+    m_txopPlanning(false),
     m_channelWidth (20),
     m_channelNumber (36),
     m_channelCenterFrequency (0),
@@ -301,6 +341,7 @@ WifiDlOfdma::WifiDlOfdma ()
     m_randomizeDataRate (0),
     m_transport ("Udp"),
     m_queueDisc ("default"),
+    m_suMuPolicy ("ns3::ThroughputSelectionPolicy"),
     m_warmup (2.0),
     m_currentSta (0),
     m_ssid (Ssid ("network-A")),
@@ -317,7 +358,12 @@ WifiDlOfdma::WifiDlOfdma ()
     phyApTxDrop(0),
     m_randomizePacketSize(false),
     m_minSampleRange(30),
-    m_maxSampleRange(250)
+    m_maxSampleRange(250),
+    m_validateSuAirtime(false),
+    m_nSuAirtimeSamples(0),
+    m_suPredictedAirtimeSum(0),
+    m_suMeasuredAirtimeSum(0),
+    m_suAirtimeErrorSum(0)
 {
 }
 
@@ -338,7 +384,12 @@ WifiDlOfdma::Config (int argc, char *argv[])
   cmd.AddValue ("enableDlOfdma", "Enable/disable DL OFDMA", m_enableDlOfdma);
   cmd.AddValue ("enableUlOfdma", "Enable/disable UL OFDMA", m_enableUlOfdma);
   cmd.AddValue ("central26Tones", "Enable use of central 26 tones", m_useCentral26TonesRus);
-  cmd.AddValue ("dlAckType", "Ack sequence type for DL OFDMA (1-3)", m_dlAckSeqType);
+  cmd.AddValue ("weightedRus", "Size RUs by the backlog and MCS of the stations (scheduler 2 only)", m_weightedRus);
+  cmd.AddValue ("suMuPolicy", "TypeId of the SU/MU selection policy, e.g., ns3::ThroughputSelectionPolicy, "
+                "ns3::QueueOccupancySelectionPolicy, ns3::LatencyTargetSelectionPolicy, ns3::LatencyAwareSelectionPolicy, "
+                "ns3::FixedSelectionPolicy or ns3::SuMuBandit (scheduler 2 only)", m_suMuPolicy);
+  cmd.AddValue ("txopPlanning", "Plan the SU and DL MU PPDUs sent in a TXOP to maximize the bytes delivered (scheduler 2 only)", m_txopPlanning);
+  cmd.AddValue ("dlAckType", "Ack sequence type for DL OFDMA (1-3, 0 to let scheduler 2 select it for every DL MU PPDU)", m_dlAckSeqType);
   cmd.AddValue ("channelWidth", "Channel bandwidth (20, 40, 80, 160)", m_channelWidth);
   cmd.AddValue ("guardInterval", "Guard Interval (800, 1600, 3200)", m_guardInterval);
   cmd.AddValue ("maxRus", "Maximum number of RUs allocated per DL MU PPDU", m_maxNRus);
@@ -357,6 +408,9 @@ WifiDlOfdma::Config (int argc, char *argv[])
   cmd.AddValue ("minSampleRange", "Lowerbound for the UniformRandomVariable used to sample packet size.", m_minSampleRange);
   cmd.AddValue ("maxSampleRange", "Upperbound for the UniformRandomVariable used to sample packet size.", m_maxSampleRange);
   cmd.AddValue ("pcap", "Name of pcap file.", m_pcap);
+  cmd.AddValue ("validateSuAirtime", "Compare the SU airtime predicted by the scheduler with the measured one (scheduler 2 only).", m_validateSuAirtime);
+  cmd.AddValue ("decisionTrace", "Name of the binary file storing the SU/MU decisions (scheduler 2 only, disabled if empty).", m_decisionTrace);
+  cmd.AddValue ("snapshotLog", "Name of the binary file storing the inputs of the SU/MU selections, to be replayed by sumu-replay (scheduler 2 only, disabled if empty).", m_snapshotLog);
   cmd.Parse (argc, argv);
   std::cout << "m_payloadSize:::::::::;"<<m_payloadSize<<"\n";
   std::cout << "m_transport:::::::::;"<<m_transport<<"\n";
@@ -494,6 +548,12 @@ WifiDlOfdma::Setup (void)
                                 "ControlMode", StringValue (oss.str ()));
 
   switch (m_dlAckSeqType) {
+    case 0:
+      // the scheduler selects the ack sequence of every DL MU PPDU
+      NS_ABORT_MSG_IF (m_scheduler != 2, "Adaptive DL ack sequence (0) is only supported by scheduler 2");
+      // WifiMacHelper::SetMultiUserScheduler takes at most eight attributes
+      Config::SetDefault ("ns3::RrsumuScheduler::AdaptiveDlAckSequence", BooleanValue (true));
+      break;
     case 1:
       Config::SetDefault ("ns3::WifiDefaultAckManager::DlMuAckSequenceType", EnumValue (WifiAcknowledgment::DL_MU_BAR_BA_SEQUENCE));
       break;
@@ -505,7 +565,7 @@ WifiDlOfdma::Setup (void)
       break;
 
     default:
-      NS_FATAL_ERROR ("Invalid DL ack sequence type (must be 1, 2 or 3)");
+      NS_FATAL_ERROR ("Invalid DL ack sequence type (must be 0, 1, 2 or 3)");
   }
 
   WifiMacHelper mac;
@@ -517,10 +577,13 @@ WifiDlOfdma::Setup (void)
         mac.SetMultiUserScheduler ("ns3::RrsumuScheduler",
                                 "NStations", UintegerValue(m_nStations),
                                 "ForceDlOfdma", BooleanValue (true),
-                                "EnableUlOfdma", BooleanValue (false),
-                                "UlPsduSize", UintegerValue (0),
-                                "EnableBsrp", BooleanValue(false),
-                                "UseCentral26TonesRus", BooleanValue(m_useCentral26TonesRus));
+                                "EnableUlOfdma", BooleanValue (m_enableUlOfdma),
+                                "UlPsduSize", UintegerValue (m_ulPsduSize),
+                                "EnableBsrp", BooleanValue (m_enableUlOfdma),
+                                "UseCentral26TonesRus", BooleanValue(m_useCentral26TonesRus),
+                                "RuAllocation", EnumValue (m_weightedRus ? RrsumuScheduler::BACKLOG_WEIGHTED_RUS
+                                                                         : RrsumuScheduler::EQUAL_SIZE_RUS),
+                                "EnableTxopPlanning", BooleanValue (m_txopPlanning));
       }
       else if ( m_scheduler == 1 ) {
 
@@ -558,6 +621,21 @@ WifiDlOfdma::Setup (void)
   m_apDevices = wifi.Install (phy, mac, m_apNodes);
   //  std::cout << "m_apDevices installed\n";
 
+  if (m_enableDlOfdma && m_scheduler == 2)
+    {
+      // every AP gets its own SU/MU selection policy, because a policy is
+      // attached to the MAC of the AP it selects the TX format for
+      ObjectFactory policyFactory;
+      policyFactory.SetTypeId (m_suMuPolicy);
+      for (uint32_t i = 0; i < m_apDevices.GetN (); i++)
+        {
+          Ptr<WifiNetDevice> apDev = DynamicCast<WifiNetDevice> (m_apDevices.Get (i));
+          Ptr<HeFrameExchangeManager> apFem = DynamicCast<HeFrameExchangeManager> (DynamicCast<RegularWifiMac> (apDev->GetMac ())->GetFrameExchangeManager ());
+          apFem->GetMultiUserScheduler ()->SetAttribute ("SelectionPolicy",
+                                                         PointerValue (policyFactory.Create<SuMuSelectionPolicy> ()));
+        }
+    }
+
  
   phy.EnablePcap(m_pcap, m_apDevices.Get(0), true);
    
@@ -811,7 +889,6 @@ WifiDlOfdma::Run (void)
 if(m_scheduler==2)
 {
   PointerValue ptr;
-  // std::cout<<"Hello I am here now ----------------------------------------"; 
   dev->GetMac ()->GetAttribute ("BE_Txop", ptr);
 
   Ptr<HeFrameExchangeManager> fem = DynamicCast<HeFrameExchangeManager>(DynamicCast<RegularWifiMac> (DynamicCast<WifiNetDevice> (m_apDevices.Get(0))->GetMac ())->GetFrameExchangeManager());
@@ -820,6 +897,31 @@ if(m_scheduler==2)
  
   sched->setAPqueue(ptr.Get<QosTxop> ()->GetWifiMacQueue());
   sched->setMacaddresses(macaddresses);
+  // fixed stream, so that the SU A-MPDU lengths drawn only depend on the run number
+  sched->AssignStreams (100);
+
+  if (!m_decisionTrace.empty ())
+    {
+      m_decisionSink = CreateObject<SuMuDecisionFileSink> ();
+      m_decisionSink->Open (m_decisionTrace);
+      sched->TraceConnectWithoutContext ("SuMuDecision",
+                                         MakeCallback (&SuMuDecisionFileSink::Write, m_decisionSink));
+    }
+
+  if (!m_snapshotLog.empty ())
+    {
+      m_snapshotSink = CreateObject<SuMuSnapshotFileSink> ();
+      m_snapshotSink->Open (m_snapshotLog);
+      sched->TraceConnectWithoutContext ("SuMuSnapshot",
+                                         MakeCallback (&SuMuSnapshotFileSink::Write, m_snapshotSink));
+    }
+
+  if (m_validateSuAirtime)
+    {
+      sched->TraceConnectWithoutContext ("SuMuDecision", MakeCallback (&WifiDlOfdma::NotifySuMuDecision, this));
+      fem->TraceConnectWithoutContext ("PsduForwardDown", MakeCallback (&WifiDlOfdma::NotifySuPsduForwardedDown, this));
+      dev->GetMac ()->TraceConnectWithoutContext ("AckedMpdu", MakeCallback (&WifiDlOfdma::NotifyApAckedMpdu, this));
+    }
 }
 
   Simulator::Stop (Seconds (m_warmup + m_simulationTime + 10));
@@ -831,6 +933,17 @@ if(m_scheduler==2)
  
 
   Simulator::Run ();
+
+  if (m_decisionSink != nullptr)
+    {
+      m_decisionSink->Close ();
+      std::cout << m_decisionSink->GetNRecords () << " SU/MU decisions written to " << m_decisionTrace << std::endl;
+    }
+  if (m_snapshotSink != nullptr)
+    {
+      m_snapshotSink->Close ();
+      std::cout << m_snapshotSink->GetNRecords () << " SU/MU snapshots written to " << m_snapshotLog << std::endl;
+    }
   std::cout << "ap" <<" mac=" << (DynamicCast<WifiNetDevice>(m_apDevices.Get(0)))->GetMac()->GetAddress()<<"\n";
   for(uint32_t  i =  0; i < m_staNodes.GetN (); i++){
     std::cout << "sta" << i <<" mac="<< macaddresses[i] <<"\n";
@@ -1022,6 +1135,8 @@ if(m_scheduler==2)
 
   double averageOverallAppLatency = overallAppLatency / m_nStations;
   std::cout << std::endl << std::endl << "Average Latency [APP] (ms): " << averageOverallAppLatency << std::endl;
+  std::cout << "Latency percentiles [APP] (ms): ";
+  PrintLatencyPercentiles (m_appLatencyMap);
 
   std::cout << std::endl << "Latencies [MAC] (ms)" << std::endl
                          << "--------------------" << std::endl;
@@ -1041,6 +1156,8 @@ if(m_scheduler==2)
 
   double averageOverallMacLatency = overallMacLatency / m_nStations;
   std::cout << std::endl << std::endl << "Average Latency [MAC] (ms): " << averageOverallMacLatency << std::endl;
+  std::cout << "Latency percentiles [MAC] (ms): ";
+  PrintLatencyPercentiles (m_macLatencyMap);
 
   std::cout << std::endl << std::endl << "Maximum BE_Txop Queue Size Reached (Packets): " << m_maxQueueSizeReached << std::endl;
 
@@ -1071,6 +1188,15 @@ if(m_scheduler==2)
                                       << m_maxAmpduRatio << ", "
                                       << m_avgAmpduRatio << ")" << std::endl;
 
+  if (m_nSuAirtimeSamples > 0)
+    {
+      std::cout << std::endl << "SU airtime validation (" << m_channelWidth << " MHz, MCS "
+                << m_mcs << ", " << m_nSuAirtimeSamples << " samples): predicted "
+                << m_suPredictedAirtimeSum / m_nSuAirtimeSamples << " us, measured "
+                << m_suMeasuredAirtimeSum / m_nSuAirtimeSamples << " us, mean relative error "
+                << 100 * m_suAirtimeErrorSum / m_nSuAirtimeSamples << "%" << std::endl;
+    }
+
   //Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> (m_apDevices.Get (0));
   std::map<Mac48Address, std::vector<uint64_t>> aggStatsMap;
   std::map<Mac48Address, std::vector<uint64_t>> aggStopReasonsMap;
@@ -1322,13 +1448,20 @@ WifiDlOfdma::StartStatistics (void)
     std::cout<<"Time: "<< Now()<<"Start Statistics"<<std::endl;
   std::cout << "startt\n";
   PointerValue ptr;
+  const uint32_t staCwMin = 31;
 for (uint32_t i = 0; i < m_staNodes.GetN (); i++)
 {
 auto dev = DynamicCast<WifiNetDevice> (m_staDevices.Get (i));
 dev->GetMac ()->GetAttribute ("BE_Txop", ptr);
-ptr.Get<QosTxop> ()->SetMinCw ( 31 );
+ptr.Get<QosTxop> ()->SetMinCw ( staCwMin );
  
 }
+  if (m_scheduler == 2 && m_enableDlOfdma)
+    {
+      // the UL SU throughput is predicted with the EDCA parameters of the stations
+      Ptr<HeFrameExchangeManager> fem = DynamicCast<HeFrameExchangeManager>(DynamicCast<RegularWifiMac> (DynamicCast<WifiNetDevice> (m_apDevices.Get (0))->GetMac ())->GetFrameExchangeManager());
+      fem->GetMultiUserScheduler ()->SetAttribute ("StaCwMin", UintegerValue (staCwMin));
+    }
 
   NS_LOG_FUNCTION (this);
 
@@ -1403,6 +1536,30 @@ ptr.Get<QosTxop> ()->SetMinCw ( 31 );
     
 }
 
+void
+WifiDlOfdma::PrintLatencyPercentiles (const std::map<uint32_t, std::vector<Time>>& latencyMap)
+{
+  std::vector<Time> latencies;
+  for (const auto& sta : latencyMap)
+    {
+      latencies.insert (latencies.end (), sta.second.begin (), sta.second.end ());
+    }
+  if (latencies.empty ())
+    {
+      std::cout << "-" << std::endl;
+      return;
+    }
+  std::sort (latencies.begin (), latencies.end ());
+  for (double percentile : {0.50, 0.95, 0.99})
+    {
+      // nearest-rank percentile
+      std::size_t rank = static_cast<std::size_t> (std::ceil (percentile * latencies.size ()));
+      std::cout << "p" << std::lround (percentile * 100) << "="
+                << latencies[std::max<std::size_t> (rank, 1) - 1].ToDouble (Time::MS) << " ";
+    }
+  std::cout << std::endl;
+}
+
 void
 WifiDlOfdma::StopStatistics (void)
 {
@@ -1580,6 +1737,47 @@ WifiDlOfdma::NotifyPsduForwardedDown (Ptr<const WifiPsdu> psdu, WifiTxVector txV
     }
 }
 
+void
+WifiDlOfdma::NotifySuMuDecision (const SuMuDecisionRecord& record)
+{
+  m_predictedSuAirtime = Seconds (0);
+  if (record.format == MultiUserScheduler::SU_TX && !record.reused && record.suDurationNs > 0)
+    {
+      m_predictedSuAirtime = NanoSeconds (record.suDurationNs);
+      m_suReceiver.CopyFrom (record.suReceiver);
+    }
+}
+
+void
+WifiDlOfdma::NotifySuPsduForwardedDown (Ptr<const WifiPsdu> psdu, WifiTxVector txVector)
+{
+  m_suTxStart = Seconds (0);
+  // only the SU PPDU sent to the receiver considered by the scheduler is measured
+  if (m_predictedSuAirtime.IsStrictlyPositive () && !txVector.IsMu ()
+      && psdu->GetHeader (0).IsQosData () && psdu->GetAddr1 () == m_suReceiver)
+    {
+      m_suTxStart = Simulator::Now ();
+    }
+}
+
+void
+WifiDlOfdma::NotifyApAckedMpdu (Ptr<const WifiMacQueueItem> mpdu)
+{
+  if (!m_suTxStart.IsStrictlyPositive () || mpdu->GetHeader ().GetAddr1 () != m_suReceiver)
+    {
+      return;
+    }
+  // the BlockAck acknowledging the SU A-MPDU has just been received
+  double measured = (Simulator::Now () - m_suTxStart).ToDouble (Time::US);
+  double predicted = m_predictedSuAirtime.ToDouble (Time::US);
+  m_nSuAirtimeSamples++;
+  m_suPredictedAirtimeSum += predicted;
+  m_suMeasuredAirtimeSum += measured;
+  m_suAirtimeErrorSum += std::abs (predicted - measured) / measured;
+  m_suTxStart = Seconds (0);
+  m_predictedSuAirtime = Seconds (0);
+}
+
 void
 WifiDlOfdma::NotifyPsduMapForwardedDown (WifiConstPsduMap psduMap, WifiTxVector txVector)
 {